@@ -4,17 +4,16 @@ in vec3 ex_Position;
 in vec2 ex_Texcoord;
 in vec3 ex_Normal;
 
-out vec4 out_Color;
-
-uniform vec4 Color;
+flat in vec4 ex_Color;
+flat in vec3 ex_Ambient;
+flat in vec3 ex_Specular;
+flat in float ex_Shininess;
 
-uniform vec3 Ambient;
-uniform vec3 Specular;
-uniform float Shininess;
+out vec4 out_Color;
 
 uniform sampler2D Texture;
 
-uniform SceneGlobals 
+layout(std140) uniform SceneGlobals 
 {
     vec3 Eye;
     vec3 Light;
@@ -24,12 +23,12 @@ void main(void)
 {
 	vec3 light_dir = normalize(Light - ex_Position);
     vec3 normal = normalize(ex_Normal);
-	vec3 diffuse = max(dot(light_dir, normal), 0.0) * Color.rgb;
+	vec3 diffuse = max(dot(light_dir, normal), 0.0) * ex_Color.rgb;
 	
     vec3 view_dir = normalize(Eye - ex_Position);
     vec3 reflect_dir = reflect(-light_dir, normal);  
-	vec3 specular = pow(max(dot(view_dir, reflect_dir), 0.0), Shininess) * Specular;
+	vec3 specular = pow(max(dot(view_dir, reflect_dir), 0.0), ex_Shininess) * ex_Specular;
 	
-	out_Color = vec4(Ambient + diffuse + specular, Color.a);
+	out_Color = vec4(ex_Ambient + diffuse + specular, ex_Color.a);
     out_Color *= texture(Texture, ex_Texcoord);
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#version 330 core
+
+in vec3 in_Position;
+in vec2 in_Texcoord;
+in vec3 in_Normal;
+in vec4 in_VertexColor;
+
+// Per instance, in place of the uniforms of bp_vert.glsl.
+in mat4 in_Model;
+in vec4 in_Color;
+in vec3 in_Ambient;
+in vec3 in_Specular;
+in float in_Shininess;
+
+out vec3 ex_Position;
+out vec2 ex_Texcoord;
+out vec3 ex_Normal;
+
+flat out vec4 ex_Color;
+flat out vec3 ex_Ambient;
+flat out vec3 ex_Specular;
+flat out float ex_Shininess;
+
+layout(std140) uniform CameraMatrices
+{
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+};
+
+void main(void)
+{
+	ex_Color = in_Color * in_VertexColor;
+	ex_Ambient = in_Ambient;
+	ex_Specular = in_Specular;
+	ex_Shininess = in_Shininess;
+
+	ex_Texcoord = in_Texcoord;
+	ex_Normal = inverse(transpose(mat3(in_Model))) * in_Normal;
+	ex_Position = vec3(in_Model * vec4(in_Position, 1));
+	gl_Position = ProjectionMatrix * ViewMatrix * in_Model * vec4(in_Position, 1);
+}
\ No newline at end of file
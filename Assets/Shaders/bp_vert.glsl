@@ -3,14 +3,25 @@
 in vec3 in_Position;
 in vec2 in_Texcoord;
 in vec3 in_Normal;
+in vec4 in_VertexColor;
 
 out vec3 ex_Position;
 out vec2 ex_Texcoord;
 out vec3 ex_Normal;
 
+flat out vec4 ex_Color;
+flat out vec3 ex_Ambient;
+flat out vec3 ex_Specular;
+flat out float ex_Shininess;
+
 uniform mat4 ModelMatrix;
 
-uniform CameraMatrices
+uniform vec4 Color;
+uniform vec3 Ambient;
+uniform vec3 Specular;
+uniform float Shininess;
+
+layout(std140) uniform CameraMatrices
 {
     mat4 ViewMatrix;
     mat4 ProjectionMatrix;
@@ -18,6 +29,11 @@ uniform CameraMatrices
 
 void main(void)
 {
+	ex_Color = Color * in_VertexColor;
+	ex_Ambient = Ambient;
+	ex_Specular = Specular;
+	ex_Shininess = Shininess;
+
 	ex_Texcoord = in_Texcoord;
 	ex_Normal = inverse(transpose(mat3(ModelMatrix))) * in_Normal;
 	ex_Position = vec3(ModelMatrix * vec4(in_Position, 1));
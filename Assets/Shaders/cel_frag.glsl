@@ -4,12 +4,13 @@ in vec3 ex_Position;
 in vec2 ex_Texcoord;
 in vec3 ex_Normal;
 
+flat in vec4 ex_Color;
+
 out vec4 out_Color;
 
-uniform vec4 Color;
 uniform sampler2D Texture;
 
-uniform SceneGlobals 
+layout(std140) uniform SceneGlobals 
 {
     vec3 Eye;
     vec3 Light;
@@ -38,6 +39,6 @@ void main(void)
 	    intensity = 0;
     }
     
-	out_Color = Color * texture(Texture, ex_Texcoord);
+	out_Color = ex_Color * texture(Texture, ex_Texcoord);
 	out_Color.xyz *= intensity;
 }
\ No newline at end of file
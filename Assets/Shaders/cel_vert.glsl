@@ -3,14 +3,18 @@
 in vec3 in_Position;
 in vec2 in_Texcoord;
 in vec3 in_Normal;
+in vec4 in_VertexColor;
 
 out vec3 ex_Position;
 out vec2 ex_Texcoord;
 out vec3 ex_Normal;
 
+flat out vec4 ex_Color;
+
 uniform mat4 ModelMatrix;
+uniform vec4 Color;
 
-uniform CameraMatrices
+layout(std140) uniform CameraMatrices
 {
     mat4 ViewMatrix;
     mat4 ProjectionMatrix;
@@ -18,6 +22,8 @@ uniform CameraMatrices
 
 void main(void)
 {
+	ex_Color = Color * in_VertexColor;
+
 	ex_Texcoord = in_Texcoord;
 	ex_Normal = inverse(transpose(mat3(ModelMatrix))) * in_Normal;
 	ex_Position = vec3(ModelMatrix * vec4(in_Position, 1));
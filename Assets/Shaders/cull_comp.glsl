@@ -0,0 +1,64 @@
+#version 430 core
+
+// Appends a command drawing each object inside the frustum to those of its multi-draw, see GpuCulling.
+layout(local_size_x = 64) in;
+
+struct Object
+{
+    vec4 center;
+    vec4 extent;
+    uint count;
+    uint first_index;
+    int base_vertex;
+    uint instance;
+    uint draw;
+    uint first_command;
+};
+
+struct DrawCommand
+{
+    uint count;
+    uint instance_count;
+    uint first_index;
+    int base_vertex;
+    uint base_instance;
+};
+
+layout(std430, binding = 0) readonly buffer Objects
+{
+    Object objects[];
+};
+
+layout(std430, binding = 1) writeonly buffer Commands
+{
+    DrawCommand commands[];
+};
+
+layout(std430, binding = 2) buffer Counters
+{
+    uint counters[];
+};
+
+// (normal, distance) in world space, with the normals pointing inwards.
+uniform vec4 Planes[6];
+uniform int ObjectCount;
+
+void main(void)
+{
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= uint(ObjectCount)) return;
+
+	// Outside when even the corner of the box farthest along a plane's normal is behind it, like Frustum::test.
+	Object object = objects[index];
+	for (int i = 0; i < 6; i++)
+	{
+		float distance = dot(Planes[i].xyz, object.center.xyz) + Planes[i].w;
+		float reach = dot(abs(Planes[i].xyz), object.extent.xyz);
+		if (distance + reach < 0) return;
+	}
+
+	uint slot = atomicAdd(counters[object.draw], 1u);
+	commands[object.first_command + slot] = DrawCommand(
+		object.count, 1u, object.first_index, object.base_vertex, object.instance
+	);
+}
\ No newline at end of file
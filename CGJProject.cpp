@@ -1,13 +1,19 @@
 #include <array>
 #include <iostream>
+#include <optional>
 #include <ostream>
+#include <string>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
 #include "Utils.h"
+#include "Engine/AssetPack.h"
 #include "Engine/Engine.h"
 #include "Engine/GlInit.h"
+#include "Engine/JobSystem.h"
+#include "Render/GlState.h"
 #include "Render/Mesh.h"
 #include "Render/Object.h"
 #include "Render/Shader.h"
@@ -105,15 +111,16 @@ namespace config::hooks
             case GLFW_KEY_F7:
                 if (const auto path = engine.file_controller.get(); path != nullptr)
                 {
+                    auto const assets = engine.file_controller.assets();
                     if (engine.file_controller.loadingMeshes())
                     {
-                        try { engine.mesh_controller.load(render::MeshLoader::fromFile(*path)); }
-                        catch (...) { }
+                        engine.asset_loader.loadMesh(*path, assets);
+                        std::cout << "loading mesh: " << *path << std::endl;
                     }
                     else if (engine.file_controller.loadingTextures())
                     {
-                        try { engine.texture_controller.load(render::TextureLoader::fromFile(*path)); }
-                        catch (...) { }
+                        engine.asset_loader.loadTexture(*path, assets);
+                        std::cout << "loading texture: " << *path << std::endl;
                     }
                     else
                     {
@@ -136,28 +143,28 @@ namespace config::hooks
                 #pragma region Object Movement
                 // Keybindings for moving the selected object, if any. 
             case GLFW_KEY_W:
-                if (auto const obj = engine.object_controller.get(); obj)
-                    obj->transform.position.z -= 0.5;
+                if (auto const obj = engine.object_controller.get())
+                    obj->editTransform().position.z -= 0.5;
                 break;
             case GLFW_KEY_S:
-                if (auto const obj = engine.object_controller.get(); obj)
-                    obj->transform.position.z += 0.5;
+                if (auto const obj = engine.object_controller.get())
+                    obj->editTransform().position.z += 0.5;
                 break;
             case GLFW_KEY_A:
-                if (auto const obj = engine.object_controller.get(); obj)
-                    obj->transform.position.x -= 0.5;
+                if (auto const obj = engine.object_controller.get())
+                    obj->editTransform().position.x -= 0.5;
                 break;
             case GLFW_KEY_D:
-                if (auto const obj = engine.object_controller.get(); obj)
-                    obj->transform.position.x += 0.5;
+                if (auto const obj = engine.object_controller.get())
+                    obj->editTransform().position.x += 0.5;
                 break;
             case GLFW_KEY_Q:
-                if (auto const obj = engine.object_controller.get(); obj)
-                    obj->transform.position.y -= 0.5;
+                if (auto const obj = engine.object_controller.get())
+                    obj->editTransform().position.y -= 0.5;
                 break;
             case GLFW_KEY_E:
-                if (auto const obj = engine.object_controller.get(); obj)
-                    obj->transform.position.y += 0.5;
+                if (auto const obj = engine.object_controller.get())
+                    obj->editTransform().position.y += 0.5;
                 break;
                 #pragma endregion Object Movement
 
@@ -199,28 +206,28 @@ namespace config::hooks
                 #pragma region Row2
                 // Keybindings for manipulating the selected object's shaders, texture or mesh.
             case GLFW_KEY_G:
-                if (auto const obj = engine.object_controller.get(); obj != nullptr)
-                    engine.object_controller.get()->shaders = engine.pipeline_controller.prev();
+                if (auto const obj = engine.object_controller.get())
+                    obj->setShaders(engine.pipeline_controller.prev());
                 break;
             case GLFW_KEY_H:
-                if (auto const obj = engine.object_controller.get(); obj != nullptr)
-                    engine.object_controller.get()->shaders = engine.pipeline_controller.next();
+                if (auto const obj = engine.object_controller.get())
+                    obj->setShaders(engine.pipeline_controller.next());
                 break;
             case GLFW_KEY_J:
-                if (auto const obj = engine.object_controller.get(); obj != nullptr)
-                    engine.object_controller.get()->texture = engine.texture_controller.prev();
+                if (auto const obj = engine.object_controller.get())
+                    obj->setTexture(engine.texture_controller.prev());
                 break;
             case GLFW_KEY_K:
-                if (auto const obj = engine.object_controller.get(); obj != nullptr)
-                    engine.object_controller.get()->texture = engine.texture_controller.next();
+                if (auto const obj = engine.object_controller.get())
+                    obj->setTexture(engine.texture_controller.next());
                 break;
             case GLFW_KEY_L:
-                if (auto const obj = engine.object_controller.get(); obj != nullptr)
-                    engine.object_controller.get()->mesh = engine.mesh_controller.prev();
+                if (auto const obj = engine.object_controller.get())
+                    obj->setMesh(engine.mesh_controller.prev());
                 break;
             case GLFW_KEY_SEMICOLON:
-                if (auto const obj = engine.object_controller.get(); obj != nullptr)
-                    engine.object_controller.get()->mesh = engine.mesh_controller.next();
+                if (auto const obj = engine.object_controller.get())
+                    obj->setMesh(engine.mesh_controller.next());
                 break;
             case GLFW_KEY_N:
                 jsonFile::saveFile(currentSettings, currentPlaneMesh, currentPieceMesh);
@@ -240,16 +247,19 @@ namespace config::hooks
     {
         auto const [width, height] = settings.window.size;
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glEnable(GL_BLEND);
-        glEnable(GL_DEPTH_TEST);
+        auto& state = render::GlState::current();
+        state.setEnabled(GL_BLEND, true);
+        state.setEnabled(GL_DEPTH_TEST, true);
         glDepthFunc(GL_LEQUAL);
         glDepthMask(GL_TRUE);
         glDepthRange(0.0, 1.0);
         glClearDepth(1.0);
-        glEnable(GL_CULL_FACE);
+        state.setEnabled(GL_CULL_FACE, true);
         glCullFace(GL_BACK);
         glFrontFace(GL_CCW);
         glViewport(0, 0, width, height);
+        // Read in place of the vertex colors by meshes without any, which is every mesh but the merged ones.
+        glVertexAttrib4f(render::Pipeline::VertexColor, 1, 1, 1, 1);
     }
 
     #pragma endregion OpenGl
@@ -264,112 +274,128 @@ namespace config::hooks
         constexpr auto CubeMargin = 0.9f;
         auto const     Scale      = Vector3::filled(CubeMargin);
 
-        auto const& [meshes, textures, shaders, filters, _] = settings.paths;
+        constexpr std::array<char const*, 12> FilterNames = {
+            "red", "green", "blue", "grayscale", "sepia", "invert",
+            "sharpen", "edge", "emboss", "blur", "sketch", "oilPainting"
+        };
 
-        Ptr<Pipeline const>                 bp_pipeline, cel_pipeline;
-        std::array<Ptr<Pipeline const>, 12> filter_pipelines;
-        Ptr<Mesh const>                     plane_mesh, piece_mesh;
+        auto const& [meshes, textures, shaders, filters, _, pack] = settings.paths;
+
+        PipelineHandle                                 bp_pipeline, cel_pipeline;
+        std::array<PipelineHandle, FilterNames.size()> filter_pipelines;
+        MeshHandle                                     plane_mesh, piece_mesh;
+        OccluderHandle                                 plane_occluder;
 
         currentSettings = settings;
 
+        builder.assets    = engine::AssetPack::open(pack);
+        auto const assets = builder.assets ? &*builder.assets : nullptr;
+
+        // Files are read, parsed and decoded on the workers, while the GL objects are created here in order as soon as
+        // each one is ready, instead of every file being loaded before the next is even opened.
+        struct ProgramSources
+        {
+            bool                                    is_filter;
+            path                                    vertex_file, fragment_file, instanced_file;
+            engine::JobSystem::Pending<std::string> vertex, fragment;
+
+            std::optional<engine::JobSystem::Pending<std::string>> instanced; // Vertex shader of the instanced variant.
+        };
+
+        auto& jobs = *builder.jobs;
+
+        auto const decodeMesh = [&](path const& file)
+        {
+            return jobs.submit(
+                [file, assets, &jobs, &geometry = settings.geometry]
+                {
+                    auto loaded = MeshLoader::fromFile(file, assets, &jobs);
+                    loaded.bake(geometry);
+                    return loaded;
+                }
+            );
+        };
+        auto const readProgram = [&](bool const is_filter, path const& dir, std::string const& name)
+        {
+            auto const read = [&](path const& file)
+            {
+                return jobs.submit([file, assets] { return Shader::readSource(file, assets); });
+            };
+
+            auto const vertex_file = dir / (name + "_vert.glsl"), fragment_file = dir / (name + "_frag.glsl");
+            auto const instanced_file = dir / (name + "_instanced_vert.glsl");
+
+            // Filters draw a single quad, so only the scene's programs have an instanced variant.
+            auto sources = ProgramSources {
+                is_filter, vertex_file, fragment_file, instanced_file, read(vertex_file), read(fragment_file), {}
+            };
+            if (!is_filter) sources.instanced.emplace(read(instanced_file));
+            return sources;
+        };
+
+        currentPlaneMesh = meshes / "Plane.obj";
+        currentPieceMesh = meshes / "Sphere16.obj";
+
+        auto plane_loader = decodeMesh(currentPlaneMesh);
+        auto cube_loader  = decodeMesh(meshes / "Cube.obj");
+        auto piece_loader = decodeMesh(currentPieceMesh);
+        auto face_loader  = jobs.submit(
+            [file = textures / "awesomeface.png", assets] { return TextureLoader::fromFile(file, assets); }
+        );
+
+        std::vector<ProgramSources> programs;
+        programs.push_back(readProgram(false, shaders, "bp"));
+        programs.push_back(readProgram(false, shaders, "cel"));
+        for (auto const name : FilterNames) { programs.push_back(readProgram(true, filters, name)); }
+
+        auto const culling_file   = shaders / "cull_comp.glsl";
+        auto       culling_source = jobs.submit(
+            [file = culling_file, assets] { return Shader::readSource(file, assets); }
+        );
+
         logTimeTaken(
             "Loading Assets",
             [&]()
             {
-                plane_mesh = &builder.meshes.emplace_back(MeshLoader::fromFile(meshes / "Plane.obj"));
-                &builder.meshes.emplace_back(MeshLoader::fromFile(meshes / "Cube.obj"));
-                piece_mesh = &builder.meshes.emplace_back(MeshLoader::fromFile(meshes / "Sphere16.obj"));
-
-                currentPlaneMesh = meshes / "Plane.obj";
-                currentPieceMesh = meshes / "Sphere16.obj";
-
-                &builder.textures.emplace_back(TextureLoader::fromFile(textures / "awesomeface.png"));
+                // The plane hides everything beneath it, so it is rasterized for the occlusion culling as well.
+                auto const plane_loaded = plane_loader.get();
+                plane_mesh     = builder.meshes.emplace(plane_loaded, settings.geometry);
+                plane_occluder = builder.occluders.emplace(OccluderMesh::fromLoader(plane_loaded));
+                builder.meshes.emplace(cube_loader.get(), settings.geometry);
+                piece_mesh = builder.meshes.emplace(piece_loader.get(), settings.geometry);
+
+                builder.textures.emplace(face_loader.get());
             }
         );
         logTimeTaken(
             "Loading Shaders",
             [&]()
             {
-                bp_pipeline = &builder.shaders.emplace_back(
-                    false,
-                    Shader::fromFile(Shader::Vertex, shaders / "bp_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, shaders / "bp_frag.glsl")
-                );
-                cel_pipeline = &builder.shaders.emplace_back(
-                    false,
-                    Shader::fromFile(Shader::Vertex, shaders / "cel_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, shaders / "cel_frag.glsl")
-                );
-
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "red_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "red_frag.glsl")
-                );
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "green_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "green_frag.glsl")
-                );
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "blue_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "blue_frag.glsl")
-                );
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "grayscale_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "grayscale_frag.glsl")
-                );
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "sepia_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "sepia_frag.glsl")
-                );
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "invert_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "invert_frag.glsl")
-                );
-
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "sharpen_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "sharpen_frag.glsl")
-                );
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "edge_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "edge_frag.glsl")
-                );
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "emboss_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "emboss_frag.glsl")
-                );
-                
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "blur_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "blur_frag.glsl")
-                );
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "sketch_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "sketch_frag.glsl")
-                );
-                builder.shaders.emplace_back(
-                    true,
-                    Shader::fromFile(Shader::Vertex, filters / "oilPainting_vert.glsl"),
-                    Shader::fromFile(Shader::Fragment, filters / "oilPainting_frag.glsl")
-                );
-
-                std::transform(
-                    builder.shaders.begin() + 2,
-                    builder.shaders.end(),
-                    filter_pipelines.begin(),
-                    [](auto const& pipeline) { return &pipeline; }
-                );
+                std::vector<PipelineHandle> pipelines;
+                for (auto& program : programs)
+                {
+                    auto const fragment = program.fragment.get();
+                    auto const handle   = builder.shaders.emplace(
+                        program.is_filter,
+                        Shader::fromSource(Shader::Vertex, program.vertex_file, program.vertex.get()),
+                        Shader::fromSource(Shader::Fragment, program.fragment_file, fragment)
+                    );
+                    if (program.instanced)
+                    {
+                        builder.shaders[handle].setInstanced(Pipeline {
+                            program.is_filter,
+                            Shader::fromSource(Shader::Vertex, program.instanced_file, program.instanced->get()),
+                            Shader::fromSource(Shader::Fragment, program.fragment_file, fragment)
+                        });
+                    }
+                    pipelines.push_back(handle);
+                }
+
+                bp_pipeline  = pipelines[0];
+                cel_pipeline = pipelines[1];
+                std::copy(pipelines.begin() + 2, pipelines.end(), filter_pipelines.begin());
+
+                builder.gpu_culling.emplace(Shader::fromSource(Shader::Compute, culling_file, culling_source.get()));
             }
         );
 
@@ -378,7 +404,7 @@ namespace config::hooks
             [&]()
             {
                 for (auto const pipeline : filter_pipelines)
-                    builder.filters.emplace_back(settings.window, pipeline);
+                    builder.filters.emplace_back(settings.window, &builder.shaders[pipeline]);
             }
         );
 
@@ -390,87 +416,93 @@ namespace config::hooks
                 builder.camera         = Camera(20, Vector3::filled(0), Pipeline::Camera);
                 builder.default_shader = bp_pipeline;
 
-                auto& plane     = builder.root->emplaceChild(plane_mesh, Vector4 {0.6, 0.6, 0.6, 1});
-                plane.shininess = 128.f;
+                auto const plane = builder.graph->root().emplaceChild(plane_mesh, Vector4 {0.6, 0.6, 0.6, 1});
+                plane.material().shininess = 128.f;
+                plane.setOccluder(plane_occluder);
 
-                auto& figure     = plane.emplaceChild(cel_pipeline);
-                figure.transform = {{0.5, 0.5, 0}};
+                auto const figure = plane.emplaceChild(cel_pipeline);
+                figure.setTransform({{0.5, 0.5, 0}});
 
-                auto& l     = figure.emplaceChild();
-                l.transform = {{1, 0, 0}, Quaternion::fromAngleAxis(Pi, Axis::Y)};
-                l.animation = {
-                    l.transform, {{1, 1, 1}, Quaternion::fromAngleAxis(2, {0.7, 0.2, 0.7})}
-                };
+                auto const l = figure.emplaceChild();
+                l.setTransform({{1, 0, 0}, Quaternion::fromAngleAxis(Pi, Axis::Y)});
+                l.setAnimation({
+                    l.transform(), {{1, 1, 1}, Quaternion::fromAngleAxis(2, {0.7, 0.2, 0.7})}
+                });
                 {
                     auto const color = Vector4 {0.7, 0, 0, 1};
 
-                    auto& c1 = l.emplaceChild(piece_mesh, color);
-                    auto& c2 = l.emplaceChild(piece_mesh, color);
-                    auto& c3 = l.emplaceChild(piece_mesh, color);
-                    auto& c4 = l.emplaceChild(piece_mesh, color);
+                    auto const c1 = l.emplaceChild(piece_mesh, color);
+                    auto const c2 = l.emplaceChild(piece_mesh, color);
+                    auto const c3 = l.emplaceChild(piece_mesh, color);
+                    auto const c4 = l.emplaceChild(piece_mesh, color);
 
-                    c1.transform.position = {0, 0, 0};
-                    c2.transform.position = {1, 0, 0};
-                    c3.transform.position = {0, 1, 0};
-                    c4.transform.position = {0, 2, 0};
+                    c1.editTransform().position = {0, 0, 0};
+                    c2.editTransform().position = {1, 0, 0};
+                    c3.editTransform().position = {0, 1, 0};
+                    c4.editTransform().position = {0, 2, 0};
 
-                    for (auto element : {&c1, &c2, &c3, &c4})
-                        element->transform.scaling = Scale;
+                    for (auto const& element : {c1, c2, c3, c4})
+                        element.editTransform().scaling = Scale;
                 }
 
-                auto& t1     = figure.emplaceChild();
-                t1.transform = {{-1, 1, 0}, Quaternion::fromAngleAxis(Pi * 3 / 2, Axis::Z)};
-                t1.animation = {
-                    t1.transform, {{0, 0, -2}, Quaternion::fromAngleAxis(-Pi * 2, Axis::Z)}
-                };
-
-                auto& t2     = figure.emplaceChild();
-                t2.transform = {{0, 3, 0}, Quaternion::fromAngleAxis(Pi, Axis::Z)};
-                t2.animation = {
-                    t2.transform, {{3, 4, 0}, Quaternion::fromAngleAxis(Pi / 2, Axis::X)}
-                };
+                auto const t1 = figure.emplaceChild();
+                t1.setTransform({{-1, 1, 0}, Quaternion::fromAngleAxis(Pi * 3 / 2, Axis::Z)});
+                t1.setAnimation({
+                    t1.transform(), {{0, 0, -2}, Quaternion::fromAngleAxis(-Pi * 2, Axis::Z)}
+                });
+
+                auto const t2 = figure.emplaceChild();
+                t2.setTransform({{0, 3, 0}, Quaternion::fromAngleAxis(Pi, Axis::Z)});
+                t2.setAnimation({
+                    t2.transform(), {{3, 4, 0}, Quaternion::fromAngleAxis(Pi / 2, Axis::X)}
+                });
                 {
                     constexpr auto color1 = Vector4 {0, 0.7, 0, 1};
                     constexpr auto color2 = Vector4 {0, 0, 0.7, 1};
 
-                    for (auto [t, color] : std::array {std::pair {&t1, color1}, std::pair {&t2, color2}})
+                    for (auto [t, color] : std::array {std::pair {t1, color1}, std::pair {t2, color2}})
                     {
-                        auto& c1 = t->emplaceChild(piece_mesh, color);
-                        auto& c2 = t->emplaceChild(piece_mesh, color);
-                        auto& c3 = t->emplaceChild(piece_mesh, color);
-                        auto& c4 = t->emplaceChild(piece_mesh, color);
-
-                        c1.transform.position = {0, 0, 0};
-                        c2.transform.position = {-1, 0, 0};
-                        c3.transform.position = {1, 0, 0};
-                        c4.transform.position = {0, 1, 0};
-
-                        for (auto element : {&c1, &c2, &c3, &c4})
-                            element->transform.scaling = Scale;
+                        auto const c1 = t.emplaceChild(piece_mesh, color);
+                        auto const c2 = t.emplaceChild(piece_mesh, color);
+                        auto const c3 = t.emplaceChild(piece_mesh, color);
+                        auto const c4 = t.emplaceChild(piece_mesh, color);
+
+                        c1.editTransform().position = {0, 0, 0};
+                        c2.editTransform().position = {-1, 0, 0};
+                        c3.editTransform().position = {1, 0, 0};
+                        c4.editTransform().position = {0, 1, 0};
+
+                        for (auto const& element : {c1, c2, c3, c4})
+                            element.editTransform().scaling = Scale;
                     }
                 }
 
-                auto& line     = figure.emplaceChild();
-                line.transform = {{-2, 0, 0}};
-                line.animation = {
-                    line.transform, {{0, 0, 0}, Quaternion::fromAngleAxis(Pi / 4, Axis::Y)}
-                };
+                auto const line = figure.emplaceChild();
+                line.setTransform({{-2, 0, 0}});
+                line.setAnimation({
+                    line.transform(), {{0, 0, 0}, Quaternion::fromAngleAxis(Pi / 4, Axis::Y)}
+                });
                 {
                     constexpr auto color = Vector4 {0.7, 0, 0.7, 1};
 
-                    auto& c1 = line.emplaceChild(piece_mesh, color);
-                    auto& c2 = line.emplaceChild(piece_mesh, color);
-                    auto& c3 = line.emplaceChild(piece_mesh, color);
-                    auto& c4 = line.emplaceChild(piece_mesh, color);
+                    auto const c1 = line.emplaceChild(piece_mesh, color);
+                    auto const c2 = line.emplaceChild(piece_mesh, color);
+                    auto const c3 = line.emplaceChild(piece_mesh, color);
+                    auto const c4 = line.emplaceChild(piece_mesh, color);
 
-                    c1.transform.position = {0, 0, 0};
-                    c2.transform.position = {0, 1, 0};
-                    c3.transform.position = {0, 2, 0};
-                    c4.transform.position = {0, 3, 0};
+                    c1.editTransform().position = {0, 0, 0};
+                    c2.editTransform().position = {0, 1, 0};
+                    c3.editTransform().position = {0, 2, 0};
+                    c4.editTransform().position = {0, 3, 0};
 
-                    for (auto element : {&c1, &c2, &c3, &c4})
-                        element->transform.scaling = Scale;
+                    for (auto const& element : {c1, c2, c3, c4})
+                        element.editTransform().scaling = Scale;
                 }
+
+                // The pieces never move within their tetromino, so each one is drawn as a single merged mesh until
+                // something in it is edited.
+                for (auto const& tetromino : {l, t1, t2, line})
+                    tetromino.freeze();
             }
         );
     }
@@ -490,12 +522,12 @@ namespace config::hooks
     #pragma endregion Scene
 }
 
-int main()
+int main(int const argc, char const* const argv[])
 {
     using namespace config;
 
     auto const settings = Settings {
-        Version {4, 3},
+        Version {4, 4}, // The frame ring maps its buffer persistently.
         Window {
             u8"Tetris 3D",
             WindowSize {640, 480},
@@ -507,12 +539,36 @@ int main()
             "Assets/Textures",
             "Assets/Shaders",
             "Assets/Shaders/Filters",
-            "Snapshots"
+            "Snapshots",
+            "Assets/Assets.pack"
+        },
+        Geometry {
+            VertexLayout::Interleaved,
+            VertexFormat::Float,
+            MeshOptimization::On,
+            MeshLods::On,
+            MeshArena::On
         }
     };
 
+    if (argc > 1 && std::string_view {argv[1]} == "--build-pack")
+    {
+        try
+        {
+            logTimeTaken("Building asset pack", [&]() { engine::AssetPack::build(settings.paths, settings.geometry); });
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     try
     {
+        engine::JobSystem jobs;
+
         auto engine = logTimeTaken(
             "Initialization",
             [&]()
@@ -520,8 +576,8 @@ int main()
                 auto glfw = engine::GlfwHandle {settings};
                 auto glew = engine::GlInit {settings};
 
-                auto scene = render::Scene::setup(std::move(glew), settings);
-                return engine::Engine::init(std::move(glfw), std::move(scene), settings);
+                auto scene = render::Scene::setup(std::move(glew), jobs, settings);
+                return engine::Engine::init(std::move(glfw), jobs, std::move(scene), settings);
             }
         );
         engine->run();
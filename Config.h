@@ -28,6 +28,42 @@ namespace config
         On = true,
     };
 
+    enum class VertexLayout : bool
+    {
+        Separate = false,
+        Interleaved = true,
+    };
+
+    // Packed vertices take 16 bytes instead of 32 and are always interleaved.
+    enum class VertexFormat : bool
+    {
+        Float = false,
+        Packed = true,
+    };
+
+    // Reorders triangles and vertices at load time for the post-transform cache, overdraw and vertex fetch.
+    enum class MeshOptimization : bool
+    {
+        Off = false,
+        On = true,
+    };
+
+    // Builds ever coarser levels of detail of every mesh at load time, drawn instead of the full mesh while it covers
+    // too little of the screen for the difference to show.
+    enum class MeshLods : bool
+    {
+        Off = false,
+        On = true,
+    };
+
+    // Places every mesh whose vertices are in a single stream into buffers shared with the others of its format, so
+    // that instanced draws of different meshes are submitted together by a single multi-draw call.
+    enum class MeshArena : bool
+    {
+        Off = false,
+        On = true,
+    };
+
     struct Window
     {
         Ptr<char const> title;
@@ -43,12 +79,23 @@ namespace config
         std::filesystem::path shaders;
         std::filesystem::path filters;
         std::filesystem::path snapshot;
+        std::filesystem::path pack; // Built with --build-pack, the loose assets are loaded when it is missing.
+    };
+
+    struct Geometry
+    {
+        VertexLayout     layout       = VertexLayout::Interleaved;
+        VertexFormat     format       = VertexFormat::Float;
+        MeshOptimization optimization = MeshOptimization::On;
+        MeshLods         lods         = MeshLods::On;
+        MeshArena        arena        = MeshArena::Off; // Built buffers fit either way.
     };
 
     struct Settings
     {
-        Version version;
-        Window  window;
-        Paths   paths;
+        Version  version;
+        Window   window;
+        Paths    paths;
+        Geometry geometry;
     };
 }
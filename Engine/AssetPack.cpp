@@ -0,0 +1,316 @@
+﻿#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <type_traits>
+
+#include <FreeImage.h>
+
+#include "../Render/Mesh.h"
+#include "../Render/Texture.h"
+
+namespace engine
+{
+    namespace
+    {
+        using namespace std::filesystem;
+
+        constexpr char        Magic[8]   = {'C', 'G', 'J', 'P', 'A', 'C', 'K', '\0'};
+        constexpr std::size_t MaxStreams = 3;
+        constexpr std::size_t Alignment  = 16;
+
+        struct Range
+        {
+            std::uint64_t offset, size;
+        };
+
+        // The header is followed by one record per asset, then by the names, then by the assets' data.
+        struct Header
+        {
+            char          magic[8];
+            std::uint32_t version;
+            std::uint32_t entry_count;
+            Range         names;
+        };
+
+        struct Record
+        {
+            AssetPack::Kind kind;
+            std::uint32_t   padding;
+            Range           name; // Within the names.
+            Range           data; // Within the file.
+        };
+
+        // Start of a mesh's data, the ranges are relative to the start of the data.
+        struct MeshRecord
+        {
+            render::MeshDescription description;
+            std::uint32_t           stream_count;
+            Range                   streams[MaxStreams];
+            Range                   indices;
+        };
+
+        // Start of a texture's data, the range is relative to the start of the data.
+        struct TextureRecord
+        {
+            std::uint32_t width, height;
+            Range         pixels;
+        };
+
+        static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<Record>);
+        static_assert(std::is_trivially_copyable_v<MeshRecord> && std::is_trivially_copyable_v<TextureRecord>);
+
+        std::uint64_t alignUp(std::uint64_t const offset) { return (offset + Alignment - 1) / Alignment * Alignment; }
+
+        bool contains(std::uint64_t const size, Range const range)
+        {
+            return range.offset <= size && range.size <= size - range.offset;
+        }
+
+        std::string keyOf(path const& file) { return file.lexically_normal().generic_string(); }
+
+        template <class T>
+        T read(Ptr<char const> const data)
+        {
+            T value;
+            std::memcpy(&value, data, sizeof(T));
+            return value;
+        }
+
+        Range append(std::vector<char>& bytes, Ptr<void const> const data, std::size_t const size)
+        {
+            auto const offset = alignUp(bytes.size());
+            bytes.resize(offset + size);
+            if (size != 0) std::memcpy(bytes.data() + offset, data, size);
+            return {offset, size};
+        }
+
+        std::vector<char> bakeMeshData(path const& mesh_file, config::Geometry const& geometry)
+        {
+            std::vector<char> bytes(sizeof(MeshRecord));
+            render::bakeMesh(
+                render::MeshLoader::fromFile(mesh_file),
+                geometry,
+                [&](render::MeshBuffers const& buffers)
+                {
+                    if (buffers.vertex_streams.size() > MaxStreams)
+                        throw std::invalid_argument("Mesh has more vertex streams than a pack can hold.");
+
+                    MeshRecord record {};
+                    record.description  = buffers.description;
+                    record.stream_count = static_cast<std::uint32_t>(buffers.vertex_streams.size());
+                    for (std::size_t i = 0; i < buffers.vertex_streams.size(); i++)
+                    {
+                        auto const [data, size] = buffers.vertex_streams[i];
+                        record.streams[i]       = append(bytes, data, size);
+                    }
+                    record.indices = append(bytes, buffers.indices.data, buffers.indices.size);
+
+                    std::memcpy(bytes.data(), &record, sizeof(record));
+                }
+            );
+            return bytes;
+        }
+
+        std::vector<char> bakeTextureData(path const& texture_file)
+        {
+            auto const loaded = render::TextureLoader::fromFile(texture_file);
+            auto const stride = loaded.width * 4;
+            if (FreeImage_GetPitch(loaded.data.get()) != stride)
+                throw std::runtime_error("Cannot pack padded texture rows: " + texture_file.string());
+
+            std::vector<char> bytes(sizeof(TextureRecord));
+            auto const        pixels = FreeImage_GetBits(loaded.data.get());
+            auto const        record = TextureRecord {
+                loaded.width,
+                loaded.height,
+                append(bytes, pixels, std::size_t {stride} * loaded.height)
+            };
+            std::memcpy(bytes.data(), &record, sizeof(record));
+            return bytes;
+        }
+
+        std::vector<char> bakeShaderData(path const& shader_file)
+        {
+            auto const source = MappedFile {shader_file};
+            return {source.view().begin(), source.view().end()};
+        }
+    }
+
+    AssetPack::AssetPack(path const& pack_file)
+        : file_ {pack_file}
+    {
+        auto const invalid = [&] { return std::runtime_error("Invalid asset pack: " + pack_file.string()); };
+
+        if (file_.size() < sizeof(Header)) throw invalid();
+        auto const header = read<Header>(file_.data());
+        if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version) throw invalid();
+
+        auto const records_end = sizeof(Header) + std::uint64_t {header.entry_count} * sizeof(Record);
+        if (records_end > file_.size() || !contains(file_.size(), header.names)) throw invalid();
+
+        entries_.reserve(header.entry_count);
+        for (std::uint32_t i = 0; i < header.entry_count; i++)
+        {
+            auto const record = read<Record>(file_.data() + sizeof(Header) + i * sizeof(Record));
+            if (!contains(header.names.size, record.name) || !contains(file_.size(), record.data)) throw invalid();
+
+            auto const name = std::string {file_.data() + header.names.offset + record.name.offset, record.name.size};
+            entries_.emplace(name, Entry {record.kind, record.data.offset, record.data.size});
+        }
+    }
+
+    std::optional<AssetPack> AssetPack::open(path const& pack_file)
+    {
+        std::error_code error;
+        if (pack_file.empty() || !is_regular_file(pack_file, error)) return std::nullopt;
+
+        try
+        {
+            return AssetPack {pack_file};
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << "Ignoring asset pack at " << pack_file << ": " << e.what() << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    void AssetPack::build(config::Paths const& paths, config::Geometry const& geometry)
+    {
+        struct Baked
+        {
+            Kind              kind;
+            std::vector<char> data;
+        };
+
+        // Sorted by name, and the filters are usually found again under the shaders, so each is only baked once.
+        std::map<std::string, Baked> assets;
+
+        auto const scan = [&](path const& dir, std::string_view const extension, Kind const kind, auto bake)
+        {
+            if (!is_directory(dir)) return;
+            for (auto& entry : recursive_directory_iterator(dir, directory_options::skip_permission_denied))
+            {
+                auto& file = entry.path();
+                if (!entry.is_regular_file() || file.extension() != extension) continue;
+                if (auto const key = keyOf(file); assets.find(key) == assets.end())
+                    assets.emplace(key, Baked {kind, bake(file)});
+            }
+        };
+
+        scan(paths.meshes, ".obj", Kind::Mesh, [&](path const& file) { return bakeMeshData(file, geometry); });
+        scan(paths.textures, ".png", Kind::Texture, bakeTextureData);
+        scan(paths.shaders, ".glsl", Kind::Shader, bakeShaderData);
+        scan(paths.filters, ".glsl", Kind::Shader, bakeShaderData);
+
+        Header header {};
+        std::memcpy(header.magic, Magic, sizeof(Magic));
+        header.version     = Version;
+        header.entry_count = static_cast<std::uint32_t>(assets.size());
+
+        std::vector<Record> records;
+        std::string         names;
+        auto                offset = std::uint64_t {0};
+        for (auto const& [name, baked] : assets)
+        {
+            records.push_back({baked.kind, 0, {names.size(), name.size()}, {offset, baked.data.size()}});
+            names += name;
+            offset = alignUp(offset + baked.data.size());
+        }
+
+        // The data offsets were relative to where the data starts, which is only known once the names are.
+        header.names     = {sizeof(Header) + records.size() * sizeof(Record), names.size()};
+        auto const start = alignUp(header.names.offset + header.names.size);
+        for (auto& record : records) { record.data.offset += start; }
+
+        // Written beside the pack and renamed over it, so a failed build never leaves a truncated pack behind.
+        auto temporary = paths.pack;
+        temporary += ".tmp";
+        {
+            std::ofstream out {temporary, std::ios::binary | std::ios::trunc};
+
+            std::uint64_t written = 0;
+            auto const    write   = [&](Ptr<void const> const data, std::uint64_t const size, std::uint64_t const at)
+            {
+                for (; written < at; written++) out.put('\0');
+                out.write(static_cast<Ptr<char const>>(data), static_cast<std::streamsize>(size));
+                written += size;
+            };
+
+            write(&header, sizeof(header), 0);
+            write(records.data(), records.size() * sizeof(Record), sizeof(Header));
+            write(names.data(), names.size(), header.names.offset);
+
+            auto record = records.begin();
+            for (auto const& [_, baked] : assets)
+                write(baked.data.data(), baked.data.size(), (record++)->data.offset);
+
+            if (!out.flush())
+                throw std::runtime_error("Cannot write asset pack: " + temporary.string());
+        }
+        rename(temporary, paths.pack);
+    }
+
+    std::optional<render::MeshBuffers> AssetPack::mesh(path const& mesh_file) const
+    {
+        auto const entry = find(mesh_file, Kind::Mesh);
+        if (!entry || entry->size < sizeof(MeshRecord)) return std::nullopt;
+
+        auto const data   = file_.data() + entry->offset;
+        auto const record = read<MeshRecord>(data);
+        if (record.stream_count > MaxStreams || !contains(entry->size, record.indices)) return std::nullopt;
+
+        auto const view = [&](Range const range) { return render::ByteView {data + range.offset, range.size}; };
+
+        render::MeshBuffers buffers {record.description, {}, view(record.indices)};
+        for (std::uint32_t i = 0; i < record.stream_count; i++)
+        {
+            if (!contains(entry->size, record.streams[i])) return std::nullopt;
+            buffers.vertex_streams.push_back(view(record.streams[i]));
+        }
+        return buffers;
+    }
+
+    std::optional<AssetPack::TexturePixels> AssetPack::texture(path const& texture_file) const
+    {
+        auto const entry = find(texture_file, Kind::Texture);
+        if (!entry || entry->size < sizeof(TextureRecord)) return std::nullopt;
+
+        auto const data   = file_.data() + entry->offset;
+        auto const record = read<TextureRecord>(data);
+        if (!contains(entry->size, record.pixels)) return std::nullopt;
+        if (record.pixels.size != std::uint64_t {record.width} * record.height * 4) return std::nullopt;
+
+        return TexturePixels {record.width, record.height, data + record.pixels.offset};
+    }
+
+    std::optional<std::string_view> AssetPack::shader(path const& shader_file) const
+    {
+        auto const entry = find(shader_file, Kind::Shader);
+        if (!entry) return std::nullopt;
+
+        return std::string_view {file_.data() + entry->offset, static_cast<std::size_t>(entry->size)};
+    }
+
+    std::vector<path> AssetPack::list(Kind const kind) const
+    {
+        std::vector<path> files;
+        for (auto const& [name, entry] : entries_)
+            if (entry.kind == kind) files.emplace_back(name);
+
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    std::optional<AssetPack::Entry> AssetPack::find(path const& file, Kind const kind) const
+    {
+        auto const entry = entries_.find(keyOf(file));
+        if (entry == entries_.end() || entry->second.kind != kind) return std::nullopt;
+        return entry->second;
+    }
+}
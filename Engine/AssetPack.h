@@ -0,0 +1,68 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+#include "../Config.h"
+#include "../Render/MeshCache.h"
+
+namespace engine
+{
+    // Meshes, textures and shader sources baked offline into a single file, which is mapped once at startup instead of
+    // opening every asset. Meshes hold their final GPU buffers and textures their decoded pixels, so both are
+    // uploaded straight from the mapping. Assets are looked up by the path they would otherwise be loaded from.
+    class AssetPack
+    {
+    public:
+        enum class Kind : std::uint32_t
+        {
+            Mesh,
+            Texture,
+            Shader,
+        };
+
+        struct TexturePixels
+        {
+            unsigned        width, height;
+            Ptr<void const> pixels; // 32 bit, in FreeImage's channel order and bottom row first.
+        };
+
+    private:
+        struct Entry
+        {
+            Kind          kind;
+            std::uint64_t offset, size;
+        };
+
+        MappedFile                             file_;
+        std::unordered_map<std::string, Entry> entries_;
+
+    public:
+        static constexpr std::uint32_t Version = 6;
+
+        [[nodiscard]] explicit AssetPack(std::filesystem::path const& pack_file);
+
+        // The pack at the path, or nothing when there is none. An unreadable pack is reported and ignored, since the
+        // loose assets are still there to fall back on.
+        static std::optional<AssetPack> open(std::filesystem::path const& pack_file);
+
+        // Bakes every mesh, texture and shader under the paths into a pack, with the meshes laid out for the geometry.
+        static void build(config::Paths const& paths, config::Geometry const& geometry);
+
+        [[nodiscard]] std::optional<render::MeshBuffers> mesh(std::filesystem::path const& mesh_file) const;
+        [[nodiscard]] std::optional<TexturePixels>       texture(std::filesystem::path const& texture_file) const;
+        [[nodiscard]] std::optional<std::string_view>    shader(std::filesystem::path const& shader_file) const;
+
+        // Paths of every asset of the kind, sorted, for browsing the pack like the asset directories.
+        [[nodiscard]] std::vector<std::filesystem::path> list(Kind kind) const;
+
+    private:
+        [[nodiscard]] std::optional<Entry> find(std::filesystem::path const& file, Kind kind) const;
+    };
+}
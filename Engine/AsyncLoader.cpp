@@ -0,0 +1,83 @@
+﻿#include "AsyncLoader.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <optional>
+
+namespace engine
+{
+    AsyncLoader::AsyncLoader(
+        JobSystem&              jobs,
+        config::Geometry const& geometry,
+        MeshController&         meshes,
+        TextureController&      textures
+    )
+        : jobs_ {jobs},
+          geometry_ {geometry},
+          meshes_ {meshes},
+          textures_ {textures},
+          cancelled_ {false}
+    {}
+
+    AsyncLoader::~AsyncLoader()
+    {
+        cancelled_ = true;
+        for (auto const& upload : uploads_) { jobs_.wait(upload); }
+    }
+
+    template <class Loader, class Load, class Upload>
+    void AsyncLoader::load(Load load, Upload upload)
+    {
+        // Finished uploads are only kept around for idle, so they are dropped whenever another load comes in.
+        uploads_.erase(std::remove_if(uploads_.begin(), uploads_.end(), JobSystem::done), uploads_.end());
+
+        auto const loaded  = std::make_shared<std::optional<Loader>>();
+        auto const decoded = jobs_.schedule(
+            [this, loaded, load]
+            {
+                if (cancelled_) return;
+                try { loaded->emplace(load()); }
+                catch (std::exception const& e) { std::cerr << "Error loading asset: " << e.what() << std::endl; }
+            }
+        );
+        uploads_.push_back(
+            jobs_.schedule(
+                [this, loaded, upload]
+                {
+                    if (cancelled_ || !*loaded) return;
+                    try { upload(std::move(**loaded)); }
+                    catch (std::exception const& e) { std::cerr << "Error uploading asset: " << e.what() << std::endl; }
+                },
+                {decoded},
+                JobSystem::Affinity::MainThread
+            )
+        );
+    }
+
+    void AsyncLoader::loadMesh(std::filesystem::path const& mesh_file, OptPtr<AssetPack const> const assets)
+    {
+        load<render::MeshLoader>(
+            [=, geometry = geometry_]
+            {
+                auto loaded = render::MeshLoader::fromFile(mesh_file, assets, &jobs_);
+                loaded.bake(geometry);
+                return loaded;
+            },
+            [this](render::MeshLoader&& loaded) { meshes_.load(std::move(loaded)); }
+        );
+    }
+
+    void AsyncLoader::loadTexture(std::filesystem::path const& texture_file, OptPtr<AssetPack const> const assets)
+    {
+        load<render::TextureLoader>(
+            [=] { return render::TextureLoader::fromFile(texture_file, assets); },
+            [this](render::TextureLoader&& loaded) { textures_.load(std::move(loaded)); }
+        );
+    }
+
+    bool AsyncLoader::idle() const
+    {
+        return std::all_of(uploads_.begin(), uploads_.end(), JobSystem::done);
+    }
+}
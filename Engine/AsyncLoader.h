@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <vector>
+
+#include "AssetPack.h"
+#include "Controller.h"
+#include "JobSystem.h"
+
+namespace engine
+{
+    // Parses, optimizes and decodes assets on the job system's workers, then hands them to the controllers from main
+    // thread jobs, which the engine runs a few per frame.
+    class AsyncLoader
+    {
+        JobSystem&                     jobs_;
+        config::Geometry               geometry_;
+        MeshController&                meshes_;
+        TextureController&             textures_;
+        std::vector<JobSystem::Handle> uploads_;
+        std::atomic<bool>              cancelled_;
+
+    public:
+        AsyncLoader(
+            JobSystem&              jobs,
+            config::Geometry const& geometry,
+            MeshController&         meshes,
+            TextureController&      textures
+        );
+
+        AsyncLoader(AsyncLoader const&)            = delete;
+        AsyncLoader& operator=(AsyncLoader const&) = delete;
+
+        // Skips whatever has not been loaded yet, but waits for the loads already running.
+        ~AsyncLoader();
+
+        void loadMesh(std::filesystem::path const& mesh_file, OptPtr<AssetPack const> assets);
+        void loadTexture(std::filesystem::path const& texture_file, OptPtr<AssetPack const> assets);
+
+        // Whether nothing is being loaded or waiting to be uploaded.
+        [[nodiscard]] bool idle() const;
+
+    private:
+        template <class Loader, class Load, class Upload>
+        void load(Load load, Upload upload);
+    };
+}
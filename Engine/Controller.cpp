@@ -26,18 +26,10 @@ namespace
         return rerefImpl(cs, iter);
     }
 
-    template <class Container, class Type>
-    typename Container::iterator findImpl(Container& cs, Ptr<Type> ptr)
+    template <class Items, class Handle>
+    Handle findImpl(Items const& items, Handle const handle)
     {
-        return std::find_if(std::begin(cs), std::end(cs), [&](Type const& it) { return &it == ptr; });
-    }
-
-    template <class Iter, class Container, class Loader>
-    OptPtr<typename Iter::value_type> loadImpl(Container& cs, Iter& iter, Loader&& loader)
-    {
-        cs.emplace_back(std::move(loader));
-        iter = --std::end(cs);
-        return rerefImpl(cs, iter);
+        return items.contains(handle) ? handle : Handle {};
     }
 
     std::vector<path>::iterator scanImpl(std::vector<path>& files, path const& dir, std::wstring_view const extension)
@@ -48,23 +40,31 @@ namespace
                 files.push_back(p);
         return files.end();
     }
+
+    std::vector<path>::iterator listImpl(
+        std::vector<path>&            files,
+        engine::AssetPack const&      assets,
+        engine::AssetPack::Kind const kind
+    )
+    {
+        files = assets.list(kind);
+        return files.end();
+    }
 }
 
 namespace engine
 {
-    MeshController::MeshController(Ptr<Collection> const items)
+    MeshController::MeshController(Ptr<Collection> const items, config::Geometry const& geometry)
         : items_ {items},
-          iter_ {items->end()}
+          geometry_ {geometry}
     {}
 
     TextureController::TextureController(Ptr<Collection> const items)
-        : items_ {items},
-          iter_ {items->end()}
+        : items_ {items}
     {}
 
     PipelineController::PipelineController(Ptr<Collection> const items)
-        : items_ {items},
-          iter_ {items->end()}
+        : items_ {items}
     {}
 
     FilterController::FilterController(Ptr<Collection> const items)
@@ -72,23 +72,24 @@ namespace engine
           iter_ {items->end()}
     {}
 
-    ObjectController::ObjectController(Ptr<Type> const root)
-        : obj_ {root},
-          iter_ {root->children.end()}
+    ObjectController::ObjectController(Ptr<render::SceneGraph> const graph)
+        : graph_ {graph},
+          obj_ {render::SceneGraph::Root}
     {}
 
-    FileController::FileController(config::Paths const& paths)
+    FileController::FileController(config::Paths const& paths, OptPtr<AssetPack const> const assets)
         : iter_ {files_.end()},
           meshes_ {paths.meshes},
-          textures_ {paths.textures}
+          textures_ {paths.textures},
+          assets_ {assets}
     {}
 
 
-    void MeshController::reset() { iter_ = items_->end(); }
-    void TextureController::reset() { iter_ = items_->end(); }
-    void PipelineController::reset() { iter_ = items_->end(); }
+    void MeshController::reset() { iter_ = {}; }
+    void TextureController::reset() { iter_ = {}; }
+    void PipelineController::reset() { iter_ = {}; }
     void FilterController::reset() { iter_ = items_->end(); }
-    void ObjectController::reset() { iter_ = obj_->children.end(); }
+    void ObjectController::reset() { iter_ = {}; }
 
     void FileController::reset()
     {
@@ -96,19 +97,21 @@ namespace engine
         current_ = std::nullopt;
     }
 
-    void MeshController::set(Ptr<Type const> const mesh) { iter_ = findImpl(*items_, mesh); }
-    void PipelineController::set(Ptr<Type const> const pipeline) { iter_ = findImpl(*items_, pipeline); }
-    void TextureController::set(Ptr<Type const> const texture) { iter_ = findImpl(*items_, texture); }
+    void MeshController::set(Handle const mesh) { iter_ = findImpl(*items_, mesh); }
+    void PipelineController::set(Handle const pipeline) { iter_ = findImpl(*items_, pipeline); }
+    void TextureController::set(Handle const texture) { iter_ = findImpl(*items_, texture); }
 
     auto FileController::set(AssetType const assets) -> void
     {
         switch (assets)
         {
         case AssetType::Mesh:
-            iter_ = scanImpl(files_, meshes_, L".obj");
+            iter_ = assets_ ? listImpl(files_, *assets_, AssetPack::Kind::Mesh) : scanImpl(files_, meshes_, L".obj");
             break;
         case AssetType::Texture:
-            iter_ = scanImpl(files_, textures_, L".png");
+            iter_ = assets_
+                        ? listImpl(files_, *assets_, AssetPack::Kind::Texture)
+                        : scanImpl(files_, textures_, L".png");
             break;
         default:
             throw std::invalid_argument("Invalid AssetType enum variant.");
@@ -119,95 +122,119 @@ namespace engine
 
     void ObjectController::recurse()
     {
-        if (std::end(obj_->children) != iter_)
+        if (graph_->alive(iter_))
         {
-            obj_  = &*iter_;
-            iter_ = obj_->children.end();
+            obj_  = iter_;
+            iter_ = {};
         }
     }
 
-    Ptr<ObjectController::Type> ObjectController::parent()
+    std::optional<ObjectController::Type> ObjectController::parent()
     {
-        if (obj_->parent)
+        if (auto const parent = browsed().parent())
         {
-            iter_ = findImpl(obj_->parent->children, obj_);
-            obj_  = obj_->parent;
+            iter_ = obj_;
+            obj_  = parent->handle();
         }
-        return rerefImpl(obj_->children, iter_);
+        return get();
     }
 
-    OptPtr<MeshController::Type>    MeshController::next() { return nextImpl(*items_, iter_); }
-    OptPtr<TextureController::Type> TextureController::next() { return nextImpl(*items_, iter_); }
-    OptPtr<FilterController::Type>  FilterController::next() { return nextImpl(*items_, iter_); }
-    OptPtr<ObjectController::Type>  ObjectController::next() { return nextImpl(obj_->children, iter_); }
+    MeshController::Handle    MeshController::next() { return iter_ = items_->next(iter_); }
+    TextureController::Handle TextureController::next() { return iter_ = items_->next(iter_); }
 
-    OptPtr<PipelineController::Type> PipelineController::next()
-    {
-        OptPtr<Type> out;
+    OptPtr<FilterController::Type> FilterController::next() { return nextImpl(*items_, iter_); }
 
-        do { out = nextImpl(*items_, iter_); }
-        while (out != nullptr && out->isFilter());
+    PipelineController::Handle PipelineController::next()
+    {
+        do { iter_ = items_->next(iter_); }
+        while (iter_ && (*items_)[iter_].isFilter());
 
-        return out;
+        return iter_;
     }
 
     OptPtr<FileController::Type> FileController::next() { return nextImpl(files_, iter_); }
 
 
-    OptPtr<MeshController::Type>    MeshController::prev() { return prevImpl(*items_, iter_); }
-    OptPtr<TextureController::Type> TextureController::prev() { return prevImpl(*items_, iter_); }
-    OptPtr<FilterController::Type>  FilterController::prev() { return prevImpl(*items_, iter_); }
-    OptPtr<ObjectController::Type>  ObjectController::prev() { return prevImpl(obj_->children, iter_); }
+    MeshController::Handle    MeshController::prev() { return iter_ = items_->prev(iter_); }
+    TextureController::Handle TextureController::prev() { return iter_ = items_->prev(iter_); }
 
-    OptPtr<PipelineController::Type> PipelineController::prev()
-    {
-        OptPtr<Type> out;
+    OptPtr<FilterController::Type> FilterController::prev() { return prevImpl(*items_, iter_); }
 
-        do { out = prevImpl(*items_, iter_); }
-        while (out != nullptr && out->isFilter());
+    PipelineController::Handle PipelineController::prev()
+    {
+        do { iter_ = items_->prev(iter_); }
+        while (iter_ && (*items_)[iter_].isFilter());
 
-        return out;
+        return iter_;
     }
 
     OptPtr<FileController::Type> FileController::prev() { return prevImpl(files_, iter_); }
 
 
-    OptPtr<MeshController::Type> MeshController::load(Loader&& loader)
+    MeshController::Handle MeshController::load(Loader&& loader)
+    {
+        return iter_ = items_->emplace(std::move(loader), geometry_);
+    }
+
+    TextureController::Handle TextureController::load(Loader&& loader)
+    {
+        return iter_ = items_->emplace(std::move(loader));
+    }
+
+    // Like the other controllers, stepping past either end selects nothing, and stepping again wraps around.
+    std::optional<ObjectController::Type> ObjectController::next()
     {
-        return loadImpl(*items_, iter_, std::move(loader));
+        auto const next = graph_->alive(iter_) ? Type {*graph_, iter_}.nextSibling() : browsed().firstChild();
+        iter_ = next ? next->handle() : Handle {};
+        return next;
     }
 
-    OptPtr<TextureController::Type> TextureController::load(Loader&& loader)
+    std::optional<ObjectController::Type> ObjectController::prev()
     {
-        return loadImpl(*items_, iter_, std::move(loader));
+        auto const prev = graph_->alive(iter_) ? Type {*graph_, iter_}.previousSibling() : browsed().lastChild();
+        iter_ = prev ? prev->handle() : Handle {};
+        return prev;
     }
 
-    OptPtr<ObjectController::Type> ObjectController::create()
+    std::optional<ObjectController::Type> ObjectController::create()
     {
-        obj_->emplaceChild();
-        iter_ = --obj_->children.end();
-        return &*iter_;
+        iter_ = browsed().emplaceChild().handle();
+        return get();
     }
 
     void ObjectController::remove()
     {
-        obj_->children.erase(iter_);
-        iter_ = obj_->children.end();
+        if (!graph_->alive(iter_)) return;
+
+        graph_->remove(iter_);
+        iter_ = {};
     }
 
-    OptPtr<MeshController::Type const>     MeshController::get() const { return rerefImpl(*items_, iter_); }
-    OptPtr<TextureController::Type const>  TextureController::get() const { return rerefImpl(*items_, iter_); }
-    OptPtr<PipelineController::Type const> PipelineController::get() const { return rerefImpl(*items_, iter_); }
+    OptPtr<MeshController::Type const>     MeshController::get() const { return items_->get(iter_); }
+    OptPtr<TextureController::Type const>  TextureController::get() const { return items_->get(iter_); }
+    OptPtr<PipelineController::Type const> PipelineController::get() const { return items_->get(iter_); }
 
     OptPtr<FilterController::Type const> FilterController::get() const { return rerefImpl(*items_, iter_); }
     OptPtr<FilterController::Type>       FilterController::get() { return rerefImpl(*items_, iter_); }
 
-    OptPtr<ObjectController::Type const> ObjectController::get() const { return rerefImpl(obj_->children, iter_); }
-    OptPtr<ObjectController::Type>       ObjectController::get() { return rerefImpl(obj_->children, iter_); }
+    // Falls back to the root when the object was removed from elsewhere.
+    ObjectController::Type ObjectController::browsed()
+    {
+        if (!graph_->alive(obj_)) obj_ = render::SceneGraph::Root;
+        return {*graph_, obj_};
+    }
+
+    std::optional<ObjectController::Type> ObjectController::get() const
+    {
+        if (!graph_->alive(iter_)) return std::nullopt;
+        return Type {*graph_, iter_};
+    }
 
     OptPtr<FileController::Type const> FileController::get() const { return rerefImpl(files_, iter_); }
     OptPtr<FileController::Type>       FileController::get() { return rerefImpl(files_, iter_); }
 
     bool FileController::loadingMeshes() const { return current_.has_value() && current_ == AssetType::Mesh; }
     bool FileController::loadingTextures() const { return current_.has_value() && current_ == AssetType::Texture; }
+
+    OptPtr<AssetPack const> FileController::assets() const { return assets_; }
 }
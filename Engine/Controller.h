@@ -1,10 +1,13 @@
 ﻿#pragma once
 #include <deque>
 
+#include "AssetPack.h"
 #include "../Utils.h"
 #include "../Render/Filter.h"
 #include "../Render/Mesh.h"
 #include "../Render/Object.h"
+#include "../Render/SceneGraph.h"
+#include "../Render/SlotMap.h"
 #include "../Render/Texture.h"
 
 namespace engine
@@ -14,19 +17,21 @@ namespace engine
     public:
         using Type = render::Mesh;
         using Loader = render::MeshLoader;
-        using Collection = std::deque<Type>;
+        using Collection = render::SlotMap<Type>;
+        using Handle = Collection::Handle;
     private:
-        Ptr<Collection>      items_;
-        Collection::iterator iter_;
+        Ptr<Collection>  items_;
+        Handle           iter_;
+        config::Geometry geometry_;
     public:
-        explicit MeshController(Ptr<Collection> items);
+        explicit MeshController(Ptr<Collection> items, config::Geometry const& geometry);
 
         void reset();
-        void set(Ptr<Type const> mesh);
+        void set(Handle mesh);
 
-        OptPtr<Type> next();
-        OptPtr<Type> prev();
-        OptPtr<Type> load(Loader&& loader);
+        Handle next();
+        Handle prev();
+        Handle load(Loader&& loader);
 
         OptPtr<Type const> get() const;
     };
@@ -36,19 +41,20 @@ namespace engine
     public:
         using Type = render::Texture;
         using Loader = render::TextureLoader;
-        using Collection = std::deque<Type>;
+        using Collection = render::SlotMap<Type>;
+        using Handle = Collection::Handle;
     private:
-        Ptr<Collection>      items_;
-        Collection::iterator iter_;
+        Ptr<Collection> items_;
+        Handle          iter_;
     public:
         explicit TextureController(Ptr<Collection> items);
 
         void reset();
-        void set(Ptr<Type const> texture);
+        void set(Handle texture);
 
-        OptPtr<Type> next();
-        OptPtr<Type> prev();
-        OptPtr<Type> load(Loader&& loader);
+        Handle next();
+        Handle prev();
+        Handle load(Loader&& loader);
 
         OptPtr<Type const> get() const;
     };
@@ -57,18 +63,19 @@ namespace engine
     {
     public:
         using Type = render::Pipeline;
-        using Collection = std::deque<Type>;
+        using Collection = render::SlotMap<Type>;
+        using Handle = Collection::Handle;
     private:
-        Ptr<Collection>      items_;
-        Collection::iterator iter_;
+        Ptr<Collection> items_;
+        Handle          iter_;
     public:
         explicit PipelineController(Ptr<Collection> items);
 
         void reset();
-        void set(Ptr<Type const> pipeline);
+        void set(Handle pipeline);
 
-        OptPtr<Type> next();
-        OptPtr<Type> prev();
+        Handle next();
+        Handle prev();
 
         OptPtr<Type const> get() const;
     };
@@ -97,25 +104,28 @@ namespace engine
     {
     public:
         using Type = render::Object;
-        using Collection = std::list<Type>;
+        using Handle = render::ObjectHandle;
     private:
-        Ptr<Type>            obj_;
-        Collection::iterator iter_;
+        Ptr<render::SceneGraph> graph_;
+        Handle                  obj_;
+        Handle                  iter_; // Selected child of obj_, null when none is.
     public:
-        explicit ObjectController(Ptr<Type> root);
+        explicit ObjectController(Ptr<render::SceneGraph> graph);
 
-        void                   reset();
-        void                   recurse();
-        OptPtr<render::Object> parent();
+        void                reset();
+        void                recurse();
+        std::optional<Type> parent();
 
-        OptPtr<Type> next();
-        OptPtr<Type> prev();
+        std::optional<Type> next();
+        std::optional<Type> prev();
 
-        OptPtr<Type> create();
-        void         remove();
+        std::optional<Type> create();
+        void                remove();
 
-        OptPtr<Type const> get() const;
-        OptPtr<Type>       get();
+        std::optional<Type> get() const;
+
+    private:
+        Type browsed(); // The object whose children are stepped through.
     };
 
     class FileController
@@ -137,9 +147,10 @@ namespace engine
         Type meshes_, textures_;
 
         std::optional<AssetType> current_;
+        OptPtr<AssetPack const>  assets_;
 
     public:
-        explicit FileController(config::Paths const& paths);
+        FileController(config::Paths const& paths, OptPtr<AssetPack const> assets);
 
         void reset();
         void set(AssetType assets);
@@ -152,5 +163,8 @@ namespace engine
 
         bool loadingMeshes() const;
         bool loadingTextures() const;
+
+        // The pack the files are listed from, if any, which must then also be given to the loaders.
+        [[nodiscard]] OptPtr<AssetPack const> assets() const;
     };
 }
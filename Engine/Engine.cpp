@@ -1,20 +1,23 @@
 ﻿#include "Engine.h"
 
 #include "Error.h"
+#include "../Render/GlState.h"
 #include <FreeImage.h>
 #include <string>
 
 namespace engine
 {
-    Engine::Engine(GlfwHandle glfw, render::Scene scene, config::Settings const& settings)
+    Engine::Engine(GlfwHandle glfw, JobSystem& jobs, render::Scene scene, config::Settings const& settings)
         : glfw_ {std::move(glfw)},
+          jobs {jobs},
           scene {std::move(scene)},
-          mesh_controller {&this->scene.meshes_},
+          mesh_controller {&this->scene.meshes_, settings.geometry},
           texture_controller {&this->scene.textures_},
           pipeline_controller {&this->scene.shaders_},
           filter_controller {&this->scene.filters_},
-          object_controller {this->scene.root_.get()},
-          file_controller {settings.paths}
+          object_controller {this->scene.graph_.get()},
+          file_controller {settings.paths, this->scene.assets_ ? &*this->scene.assets_ : nullptr},
+          asset_loader {jobs, settings.geometry, mesh_controller, texture_controller}
     {
         auto const [width, height] = settings.window.size;
 
@@ -27,9 +30,14 @@ namespace engine
         setupErrorCallback(this);
     }
 
-    std::unique_ptr<Engine> Engine::init(GlfwHandle glfw, render::Scene scene, config::Settings const& settings)
+    std::unique_ptr<Engine> Engine::init(
+        GlfwHandle              glfw,
+        JobSystem&              jobs,
+        render::Scene           scene,
+        config::Settings const& settings
+    )
     {
-        return std::unique_ptr<Engine> {new Engine(std::move(glfw), std::move(scene), settings)};
+        return std::unique_ptr<Engine> {new Engine(std::move(glfw), jobs, std::move(scene), settings)};
     }
 
     Ptr<GLFWwindow>      Engine::window() { return glfw_.window_; }
@@ -49,13 +57,13 @@ namespace engine
         pipeline_controller.reset();
     }
 
-    void Engine::setControllers(Ptr<render::Object const> const object)
+    void Engine::setControllers(std::optional<render::Object> const object)
     {
-        if (object != nullptr)
+        if (object)
         {
-            mesh_controller.set(object->mesh);
-            texture_controller.set(object->texture);
-            pipeline_controller.set(object->shaders);
+            mesh_controller.set(object->mesh());
+            texture_controller.set(object->texture());
+            pipeline_controller.set(object->shaders());
         }
     }
 
@@ -93,6 +101,10 @@ namespace engine
     void Engine::run()
     {
         auto last_time = glfw_.getTime();
+        #ifdef _DEBUG
+        auto report_time = last_time;
+        auto frames      = 0;
+        #endif
 
         while (!glfw_.windowClosing())
         {
@@ -108,9 +120,34 @@ namespace engine
             ///////////////////////////////
 
             glfw_.swapBuffers();
+            render::GlState::current().endFrame();
+            #ifdef _DEBUG
+            frames++;
+            if (now - report_time >= 1.0)
+            {
+                report(frames / (now - report_time));
+                report_time = now;
+                frames      = 0;
+            }
+            #endif
             glfw_.pollEvents();
+
+            jobs.runMainThreadJobs();
         }
     }
 
     void Engine::terminate() { glfw_.closeWindow(); }
+
+    void Engine::report(double const frames_per_sec) const
+    {
+        auto const gl    = render::GlState::current().lastFrame();
+        auto const frame = scene.frameStats();
+        auto const graph = scene.graphStats();
+
+        std::cerr << static_cast<int>(frames_per_sec) << " fps, " << frame.draws << " draws, " << gl.issued
+                  << " state changes issued and " << gl.skipped << " skipped, " << frame.occluder_triangles
+                  << " occluder triangles, frame ring peak " << frame.ring_peak << " of " << frame.ring_segment
+                  << " bytes, " << graph.live << " objects (peak " << graph.peak << ") in " << graph.capacity
+                  << " slots, " << static_cast<int>(graph.fragmentation * 100) << "% fragmented" << std::endl;
+    }
 }
@@ -3,8 +3,10 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "AsyncLoader.h"
 #include "Controller.h"
 #include "GlfwHandle.h"
+#include "JobSystem.h"
 #include "../Render/Object.h"
 #include "../Render/Scene.h"
 
@@ -19,6 +21,7 @@ namespace engine
         int                   snap_num_;
 
     public:
+        JobSystem&         jobs;
         render::Scene      scene;
         MeshController     mesh_controller;
         TextureController  texture_controller;
@@ -26,11 +29,17 @@ namespace engine
         FilterController   filter_controller;
         ObjectController   object_controller;
         FileController     file_controller;
+        AsyncLoader        asset_loader;
 
     private:
-        Engine(GlfwHandle glfw, render::Scene scene, config::Settings const& settings);
+        Engine(GlfwHandle glfw, JobSystem& jobs, render::Scene scene, config::Settings const& settings);
     public:
-        static std::unique_ptr<Engine> init(GlfwHandle glfw, render::Scene scene, config::Settings const& settings);
+        static std::unique_ptr<Engine> init(
+            GlfwHandle              glfw,
+            JobSystem&              jobs,
+            render::Scene           scene,
+            config::Settings const& settings
+        );
 
         Engine(Engine const&)            = delete;
         Engine& operator=(Engine const&) = delete;
@@ -43,10 +52,14 @@ namespace engine
 
         void resize(callback::WindowSize size);
         void resetControllers();
-        void setControllers(Ptr<render::Object const> object);
+        void setControllers(std::optional<render::Object> object);
 
         void snapshot();
         void run();
         void terminate();
+
+    private:
+        // Writes the frame rate, with what the last frame took and the size of the scene graph, to the error stream.
+        void report(double frames_per_sec) const;
     };
 }
@@ -0,0 +1,223 @@
+﻿#include "JobSystem.h"
+
+#include <iostream>
+
+namespace engine
+{
+    class JobSystem::Job
+    {
+    public:
+        std::function<void()> work;
+        Affinity              affinity;
+
+        // Unfinished dependencies, plus one held while the job is being scheduled.
+        std::atomic<std::size_t> remaining;
+
+        std::mutex              mutex;
+        std::condition_variable finished;
+        bool                    done = false;
+        std::vector<Handle>     continuations;
+
+        Job(std::function<void()>&& work, Affinity const affinity)
+            : work {std::move(work)},
+              affinity {affinity},
+              remaining {1}
+        {}
+    };
+
+    namespace
+    {
+        // Which system and worker the current thread belongs to, so jobs scheduled from a job stay on its deque.
+        thread_local Ptr<JobSystem const> current_system = nullptr;
+        thread_local std::size_t          current_worker = 0;
+    }
+
+    JobSystem::JobSystem(unsigned const worker_count)
+        : main_thread_id_ {std::this_thread::get_id()},
+          queued_ {0},
+          stopping_ {false}
+    {
+        for (unsigned i = 0; i < worker_count; i++) { workers_.push_back(std::make_unique<Worker>()); }
+        for (unsigned i = 0; i < worker_count; i++) { threads_.emplace_back([this, i] { work(i); }); }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard lock {sleep_mutex_};
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_) { thread.join(); }
+    }
+
+    JobSystem::Handle JobSystem::schedule(
+        std::function<void()>      work,
+        std::vector<Handle> const& dependencies,
+        Affinity const             affinity
+    )
+    {
+        auto job = std::make_shared<Job>(std::move(work), affinity);
+        for (auto const& dependency : dependencies)
+        {
+            std::lock_guard lock {dependency->mutex};
+            if (dependency->done) continue;
+
+            job->remaining++;
+            dependency->continuations.push_back(job);
+        }
+        release(job);
+        return job;
+    }
+
+    void JobSystem::wait(Handle const& job)
+    {
+        auto const on_main_thread = std::this_thread::get_id() == main_thread_id_;
+        auto const own            = current_system == this ? workers_[current_worker].get() : nullptr;
+
+        while (!done(job))
+        {
+            auto next = on_main_thread ? take(main_thread_, false) : nullptr;
+            if (next == nullptr) next = find(own);
+            if (next != nullptr)
+            {
+                run(next);
+                continue;
+            }
+
+            // Nothing to help with, so the job is running elsewhere. Still check back, new work may show up meanwhile.
+            std::unique_lock lock {job->mutex};
+            job->finished.wait_for(lock, std::chrono::milliseconds {1}, [&] { return job->done; });
+        }
+    }
+
+    bool JobSystem::done(Handle const& job)
+    {
+        std::lock_guard lock {job->mutex};
+        return job->done;
+    }
+
+    std::size_t JobSystem::runMainThreadJobs(std::chrono::microseconds const budget)
+    {
+        using namespace std::chrono;
+
+        auto const  start = steady_clock::now();
+        std::size_t count = 0;
+        do
+        {
+            auto const job = take(main_thread_, false);
+            if (job == nullptr) break;
+
+            run(job);
+            count++;
+        }
+        while (steady_clock::now() - start < budget);
+
+        return count;
+    }
+
+    std::size_t JobSystem::workerCount() const { return workers_.size(); }
+
+    void JobSystem::enqueue(Handle const& job)
+    {
+        if (job->affinity == Affinity::MainThread)
+        {
+            std::lock_guard lock {main_thread_.mutex};
+            main_thread_.jobs.push_back(job);
+            return;
+        }
+
+        auto& queue = current_system == this ? *workers_[current_worker] : injected_;
+        {
+            std::lock_guard lock {queue.mutex};
+            queue.jobs.push_back(job);
+        }
+        queued_++;
+
+        // Taking the lock orders the push before a worker that just found nothing goes to sleep.
+        { std::lock_guard lock {sleep_mutex_}; }
+        wake_.notify_one();
+    }
+
+    void JobSystem::release(Handle const& job)
+    {
+        if (--job->remaining == 0) enqueue(job);
+    }
+
+    void JobSystem::run(Handle const& job)
+    {
+        try { job->work(); }
+        catch (std::exception const& e) { std::cerr << "Error running job: " << e.what() << std::endl; }
+        catch (...) { std::cerr << "Error running job: unknown exception" << std::endl; }
+        job->work = nullptr;
+
+        std::vector<Handle> continuations;
+        {
+            std::lock_guard lock {job->mutex};
+            job->done = true;
+            continuations.swap(job->continuations);
+        }
+        job->finished.notify_all();
+
+        for (auto const& continuation : continuations) { release(continuation); }
+    }
+
+    void JobSystem::work(std::size_t const index)
+    {
+        current_system = this;
+        current_worker = index;
+
+        auto& own = *workers_[index];
+        while (true)
+        {
+            if (auto const job = find(&own); job != nullptr)
+            {
+                run(job);
+                continue;
+            }
+
+            std::unique_lock lock {sleep_mutex_};
+            wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+            if (stopping_ && queued_ == 0) return;
+        }
+    }
+
+    JobSystem::Handle JobSystem::take(Worker& queue, bool const back)
+    {
+        std::lock_guard lock {queue.mutex};
+        if (queue.jobs.empty()) return nullptr;
+
+        Handle job;
+        if (back)
+        {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+        else
+        {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        if (&queue != &main_thread_) queued_--;
+        return job;
+    }
+
+    JobSystem::Handle JobSystem::find(OptPtr<Worker> const own)
+    {
+        // Newest first from the own deque, as its data is likely still in cache, oldest first from everywhere else.
+        if (own != nullptr)
+        {
+            if (auto job = take(*own, true); job != nullptr) return job;
+        }
+        if (auto job = take(injected_, false); job != nullptr) return job;
+
+        auto const start = own != nullptr ? current_worker + 1 : 0;
+        for (std::size_t i = 0; i < workers_.size(); i++)
+        {
+            auto& victim = *workers_[(start + i) % workers_.size()];
+            if (&victim == own) continue;
+            if (auto job = take(victim, false); job != nullptr) return job;
+        }
+        return nullptr;
+    }
+}
@@ -0,0 +1,178 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../Utils.h"
+
+namespace engine
+{
+    // Work-stealing scheduler shared by everything that runs in parallel. Each worker pushes and pops the jobs it
+    // schedules at the back of its own deque and steals from the front of the others' when it runs dry. Jobs only
+    // start once all of their dependencies have finished, and jobs with main thread affinity are queued until the main
+    // thread runs them, which is where anything touching the GL context has to go.
+    class JobSystem
+    {
+    public:
+        enum class Affinity : bool
+        {
+            Workers    = false,
+            MainThread = true,
+        };
+
+        class Job;
+        using Handle = std::shared_ptr<Job>;
+
+        // Main thread time spent on queued jobs per frame, past the first job, which always gets through.
+        static constexpr auto DefaultFrameBudget = std::chrono::milliseconds {4};
+
+        // A submitted job along with the future of its result. Like a future from std::async, it waits for the job when
+        // destroyed, so whatever the job refers to can safely go out of scope right after.
+        template <class T>
+        class Pending
+        {
+            Ptr<JobSystem> system_;
+            Handle         job_;
+            std::future<T> result_;
+
+        public:
+            Pending(JobSystem& system, Handle job, std::future<T> result)
+                : system_ {&system},
+                  job_ {std::move(job)},
+                  result_ {std::move(result)}
+            {}
+
+            Pending(Pending&&) noexcept        = default;
+            Pending& operator=(Pending&&)      = delete;
+            Pending(Pending const&)            = delete;
+            Pending& operator=(Pending const&) = delete;
+
+            ~Pending()
+            {
+                if (job_ != nullptr) system_->wait(job_);
+            }
+
+            [[nodiscard]] Handle const& job() const { return job_; }
+
+            // Helps running jobs until this one is done, then rethrows whatever it threw.
+            T get()
+            {
+                system_->wait(job_);
+                return result_.get();
+            }
+        };
+
+    private:
+        struct Worker
+        {
+            std::mutex         mutex;
+            std::deque<Handle> jobs;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        Worker                               injected_;    // Jobs scheduled from outside the workers.
+        Worker                               main_thread_; // Jobs waiting for the main thread.
+        std::thread::id                      main_thread_id_;
+
+        std::atomic<std::size_t> queued_;
+        std::mutex               sleep_mutex_;
+        std::condition_variable  wake_;
+        bool                     stopping_;
+
+        std::vector<std::thread> threads_;
+
+    public:
+        // The thread constructing the system becomes its main thread.
+        explicit JobSystem(unsigned worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1);
+
+        JobSystem(JobSystem const&)            = delete;
+        JobSystem& operator=(JobSystem const&) = delete;
+
+        // Finishes every job already handed to the workers. Main thread jobs that were never run are dropped.
+        ~JobSystem();
+
+        // Exceptions escaping the work are logged, use submit to get them back instead.
+        Handle schedule(
+            std::function<void()>      work,
+            std::vector<Handle> const& dependencies = {},
+            Affinity                   affinity     = Affinity::Workers
+        );
+
+        template <class Task>
+        Pending<std::invoke_result_t<Task&>> submit(
+            Task                       task,
+            std::vector<Handle> const& dependencies = {},
+            Affinity                   affinity     = Affinity::Workers
+        )
+        {
+            using Result = std::invoke_result_t<Task&>;
+
+            // std::function needs a copyable target, which a packaged task is not.
+            auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+            auto result   = packaged->get_future();
+            auto job      = schedule([packaged] { (*packaged)(); }, dependencies, affinity);
+            return {*this, std::move(job), std::move(result)};
+        }
+
+        // Calls body(begin, end) over consecutive ranges of at most grain indices covering [0, count) in parallel,
+        // returning once all are done and rethrowing the first exception any of them threw.
+        template <class Body>
+        void parallelFor(std::size_t const count, std::size_t const grain, Body const& body)
+        {
+            std::exception_ptr error;
+            std::mutex         error_mutex;
+
+            std::vector<Handle> chunks;
+            for (std::size_t begin = 0; begin < count; begin += std::max<std::size_t>(grain, 1))
+            {
+                auto const end = std::min(count, begin + std::max<std::size_t>(grain, 1));
+                chunks.push_back(
+                    schedule(
+                        [&, begin, end]
+                        {
+                            try { body(begin, end); }
+                            catch (...)
+                            {
+                                std::lock_guard lock {error_mutex};
+                                if (!error) error = std::current_exception();
+                            }
+                        }
+                    )
+                );
+            }
+            for (auto const& chunk : chunks) { wait(chunk); }
+
+            if (error) std::rethrow_exception(error);
+        }
+
+        // Runs other jobs until the job is done, including main thread jobs when called from the main thread.
+        void wait(Handle const& job);
+
+        [[nodiscard]] static bool done(Handle const& job);
+
+        // Runs queued main thread jobs until the budget runs out, returning how many were run.
+        std::size_t runMainThreadJobs(std::chrono::microseconds budget = DefaultFrameBudget);
+
+        [[nodiscard]] std::size_t workerCount() const;
+
+    private:
+        void enqueue(Handle const& job);
+        void release(Handle const& job);
+        void run(Handle const& job);
+        void work(std::size_t index);
+
+        [[nodiscard]] Handle take(Worker& own, bool back);
+        [[nodiscard]] Handle find(OptPtr<Worker> own);
+    };
+}
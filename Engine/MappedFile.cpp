@@ -0,0 +1,159 @@
+﻿#include "MappedFile.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine
+{
+    #ifdef _WIN32
+    MappedFile::MappedFile(std::filesystem::path const& file)
+        : data_ {nullptr},
+          size_ {0},
+          file_ {INVALID_HANDLE_VALUE},
+          mapping_ {nullptr}
+    {
+        file_ = CreateFileW(
+            file.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr
+        );
+        if (file_ == INVALID_HANDLE_VALUE)
+            throw std::invalid_argument("Cannot open file: " + file.string());
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size))
+        {
+            release();
+            throw std::runtime_error("Cannot read size of file: " + file.string());
+        }
+        size_ = static_cast<std::size_t>(size.QuadPart);
+
+        // Empty files cannot be mapped, they are simply exposed as an empty view.
+        if (size_ == 0) return;
+
+        mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr)
+        {
+            release();
+            throw std::runtime_error("Cannot map file: " + file.string());
+        }
+
+        data_ = static_cast<Ptr<char const>>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (data_ == nullptr)
+        {
+            release();
+            throw std::runtime_error("Cannot map file: " + file.string());
+        }
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : data_ {std::exchange(other.data_, nullptr)},
+          size_ {std::exchange(other.size_, 0)},
+          file_ {std::exchange(other.file_, INVALID_HANDLE_VALUE)},
+          mapping_ {std::exchange(other.mapping_, nullptr)}
+    {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            data_    = std::exchange(other.data_, nullptr);
+            size_    = std::exchange(other.size_, 0);
+            file_    = std::exchange(other.file_, INVALID_HANDLE_VALUE);
+            mapping_ = std::exchange(other.mapping_, nullptr);
+        }
+        return *this;
+    }
+
+    void MappedFile::release()
+    {
+        if (data_ != nullptr) UnmapViewOfFile(data_);
+        if (mapping_ != nullptr) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+
+        data_    = nullptr;
+        size_    = 0;
+        mapping_ = nullptr;
+        file_    = INVALID_HANDLE_VALUE;
+    }
+    #else
+    MappedFile::MappedFile(std::filesystem::path const& file)
+        : data_ {nullptr},
+          size_ {0},
+          fd_ {open(file.c_str(), O_RDONLY)}
+    {
+        if (fd_ == -1)
+            throw std::invalid_argument("Cannot open file: " + file.string());
+
+        struct stat info {};
+        if (fstat(fd_, &info) != 0)
+        {
+            release();
+            throw std::runtime_error("Cannot read size of file: " + file.string());
+        }
+        size_ = static_cast<std::size_t>(info.st_size);
+
+        // Empty files cannot be mapped, they are simply exposed as an empty view.
+        if (size_ == 0) return;
+
+        auto const mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (mapped == MAP_FAILED)
+        {
+            release();
+            throw std::runtime_error("Cannot map file: " + file.string());
+        }
+        data_ = static_cast<Ptr<char const>>(mapped);
+        madvise(mapped, size_, MADV_SEQUENTIAL);
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : data_ {std::exchange(other.data_, nullptr)},
+          size_ {std::exchange(other.size_, 0)},
+          fd_ {std::exchange(other.fd_, -1)}
+    {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            fd_   = std::exchange(other.fd_, -1);
+        }
+        return *this;
+    }
+
+    void MappedFile::release()
+    {
+        if (data_ != nullptr) munmap(const_cast<Ptr<char>>(data_), size_);
+        if (fd_ != -1) close(fd_);
+
+        data_ = nullptr;
+        size_ = 0;
+        fd_   = -1;
+    }
+    #endif
+
+    MappedFile::~MappedFile() { release(); }
+
+    Ptr<char const>  MappedFile::data() const { return data_; }
+    std::size_t      MappedFile::size() const { return size_; }
+    std::string_view MappedFile::view() const { return {data_, size_}; }
+}
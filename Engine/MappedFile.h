@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+#include "../Utils.h"
+
+namespace engine
+{
+    // Read-only view of a whole file, mapped into the address space instead of being copied into a buffer.
+    class MappedFile
+    {
+        Ptr<char const> data_;
+        std::size_t     size_;
+
+        #ifdef _WIN32
+        Ptr<void> file_, mapping_;
+        #else
+        int fd_;
+        #endif
+
+    public:
+        [[nodiscard]] explicit MappedFile(std::filesystem::path const& file);
+
+        MappedFile(MappedFile const&)            = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        ~MappedFile();
+
+        [[nodiscard]] Ptr<char const>  data() const;
+        [[nodiscard]] std::size_t      size() const;
+        [[nodiscard]] std::string_view view() const;
+
+    private:
+        void release();
+    };
+}
@@ -0,0 +1,115 @@
+﻿#include "Bounds.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace render
+{
+    Box Box::empty()
+    {
+        constexpr auto Infinity = std::numeric_limits<float>::infinity();
+        return {Vector3::filled(Infinity), Vector3::filled(-Infinity)};
+    }
+
+    Box Box::of(std::vector<Vector3> const& points)
+    {
+        auto box = empty();
+        for (auto const [x, y, z] : points)
+        {
+            box.min = {std::min(box.min.x, x), std::min(box.min.y, y), std::min(box.min.z, z)};
+            box.max = {std::max(box.max.x, x), std::max(box.max.y, y), std::max(box.max.z, z)};
+        }
+        return box;
+    }
+
+    bool Box::isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+    Box Box::merged(Box const& other) const
+    {
+        return {
+            {std::min(min.x, other.min.x), std::min(min.y, other.min.y), std::min(min.z, other.min.z)},
+            {std::max(max.x, other.max.x), std::max(max.y, other.max.y), std::max(max.z, other.max.z)}
+        };
+    }
+
+    Box Box::transformed(Matrix4 const& matrix) const
+    {
+        if (isEmpty()) return *this;
+
+        // The center moves with the matrix, and each new half extent is the longest reach of the transformed axes.
+        auto const center = (min + max) * 0.5f;
+        auto const extent = (max - min) * 0.5f;
+
+        float moved[3], reach[3];
+        for (std::size_t row = 0; row < 3; row++)
+        {
+            auto const m = [&](std::size_t const column) { return matrix[row * 4 + column]; };
+            moved[row]   = m(0) * center.x + m(1) * center.y + m(2) * center.z + m(3);
+            reach[row]   = std::abs(m(0)) * extent.x + std::abs(m(1)) * extent.y + std::abs(m(2)) * extent.z;
+        }
+        return {
+            {moved[0] - reach[0], moved[1] - reach[1], moved[2] - reach[2]},
+            {moved[0] + reach[0], moved[1] + reach[1], moved[2] + reach[2]}
+        };
+    }
+
+    Frustum::Frustum(Matrix4 const& view_projection)
+    {
+        // A point is inside when -w <= x, y, z <= w in clip space, and each of those is a plane in world space.
+        auto const row = [&](std::size_t const index)
+        {
+            auto const& m = view_projection;
+            return Vector4 {m[index * 4], m[index * 4 + 1], m[index * 4 + 2], m[index * 4 + 3]};
+        };
+
+        auto const w = row(3);
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            planes_[axis * 2]     = w + row(axis);
+            planes_[axis * 2 + 1] = w - row(axis);
+        }
+    }
+
+    Frustum::Test Frustum::test(Box const& box) const
+    {
+        if (box.isEmpty()) return Test::Outside;
+
+        auto const center = (box.min + box.max) * 0.5f;
+        auto const extent = (box.max - box.min) * 0.5f;
+
+        auto result = Test::Inside;
+        for (auto const [x, y, z, d] : planes_)
+        {
+            auto const distance = x * center.x + y * center.y + z * center.z + d;
+            auto const reach    = std::abs(x) * extent.x + std::abs(y) * extent.y + std::abs(z) * extent.z;
+            if (distance + reach < 0) return Test::Outside;
+            if (distance - reach < 0) result = Test::Intersects;
+        }
+        return result;
+    }
+
+    std::array<Vector4, 6> const& Frustum::planes() const { return planes_; }
+
+    ScreenSize::ScreenSize(Matrix4 const& view_projection, float const viewport_height)
+    {
+        auto const& m = view_projection;
+        w_row_        = {m[12], m[13], m[14], m[15]};
+
+        // NDC spans 2 units across the viewport, and y_ndc = (row 1 . p) / w.
+        auto const y_axis = Vector3 {m[4], m[5], m[6]};
+        pixels_per_unit_  = y_axis.magnitude() * viewport_height * 0.5f;
+    }
+
+    float ScreenSize::radius(Box const& box) const
+    {
+        if (box.isEmpty()) return 0;
+
+        auto const center   = (box.min + box.max) * 0.5f;
+        auto const radius   = ((box.max - box.min) * 0.5f).magnitude();
+        auto const distance = w_row_.x * center.x + w_row_.y * center.y + w_row_.z * center.z + w_row_.w;
+        if (distance <= radius) return std::numeric_limits<float>::infinity();
+
+        return radius * pixels_per_unit_ / distance;
+    }
+}
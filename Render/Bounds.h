@@ -0,0 +1,59 @@
+﻿#pragma once
+
+#include <array>
+#include <vector>
+
+#include "../Math/Matrix.h"
+#include "../Math/Vector.h"
+
+namespace render
+{
+    // Axis aligned box, empty when its minimum exceeds its maximum.
+    struct Box
+    {
+        Vector3 min, max;
+
+        static Box empty();
+        static Box of(std::vector<Vector3> const& points);
+
+        [[nodiscard]] bool isEmpty() const;
+        [[nodiscard]] Box  merged(Box const& other) const;
+        // Smallest box around this one once transformed by the affine matrix.
+        [[nodiscard]] Box transformed(Matrix4 const& matrix) const;
+    };
+
+    // Volume a view projection matrix maps into clip space, as the planes bounding it.
+    class Frustum
+    {
+        std::array<Vector4, 6> planes_; // (normal, distance), with the normals pointing inwards.
+
+    public:
+        enum class Test
+        {
+            Outside,
+            Intersects,
+            Inside,
+        };
+
+        explicit Frustum(Matrix4 const& view_projection);
+
+        // Conservative, a box near a corner of the frustum may intersect it without being entirely outside any plane.
+        [[nodiscard]] Test test(Box const& box) const;
+
+        [[nodiscard]] std::array<Vector4, 6> const& planes() const;
+    };
+
+    // Sizes on screen of what a view projection matrix projects onto a viewport, in pixels.
+    class ScreenSize
+    {
+        Vector4 w_row_;           // Row of the matrix that computes the distance along the view direction.
+        float   pixels_per_unit_; // Of a length one unit away, across the projection's y axis.
+
+    public:
+        ScreenSize(Matrix4 const& view_projection, float viewport_height);
+
+        // Projected radius of the sphere around the box, infinite when the sphere reaches the eye. Distorting towards
+        // the edges of wide fields of view is neglected, so it errs on the small side there.
+        [[nodiscard]] float radius(Box const& box) const;
+    };
+}
@@ -17,48 +17,12 @@ namespace render
     }
 
     Camera::Camera(float const distance, Vector3 const focus, GLuint const view_id)
-        : focus_ {focus},
+        : view_id_ {view_id},
+          focus_ {focus},
           distance_ {distance},
           rotation_ {Matrix4::identity()}
-    {
-        glGenBuffers(1, &cam_matrices_id_);
-        glBindBuffer(GL_UNIFORM_BUFFER, cam_matrices_id_);
-        {
-            glBufferData(GL_UNIFORM_BUFFER, sizeof(Matrix4) * 2, nullptr, GL_STREAM_DRAW);
-            glBindBufferBase(GL_UNIFORM_BUFFER, view_id, cam_matrices_id_);
-        }
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
-    }
-
-
-    Camera::Camera(Camera&& other) noexcept
-        : cam_matrices_id_ {std::exchange(other.cam_matrices_id_, 0)},
-          focus_ {other.focus_},
-          distance_ {other.distance_},
-          rotation_ {std::exchange(other.rotation_, {})}
     {}
 
-    Camera& Camera::operator=(Camera&& other) noexcept
-    {
-        if (this != &other)
-        {
-            cam_matrices_id_ = std::exchange(other.cam_matrices_id_, 0);
-            focus_           = other.focus_;
-            distance_        = other.distance_;
-            rotation_        = std::exchange(other.rotation_, {});
-        }
-        return *this;
-    }
-
-    Camera::~Camera()
-    {
-        if (cam_matrices_id_ != 0)
-        {
-            glDeleteBuffers(1, &cam_matrices_id_);
-            glBindBuffer(GL_UNIFORM_BUFFER, 0);
-        }
-    }
-
     void Camera::swapRotationMode()
     {
         if (auto const mat = std::get_if<Matrix4>(&rotation_))
@@ -96,16 +60,18 @@ namespace render
         auto const view_matrix =
             Matrix4::translation({0, 0, -distance_}) * rotation_matrix.transposed() * Matrix4::translation(-focus_);
 
-        glBindBuffer(GL_UNIFORM_BUFFER, cam_matrices_id_);
-        {
-            glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Matrix4), view_matrix.transposed().inner);
-            glBufferSubData(GL_UNIFORM_BUFFER, sizeof(Matrix4), sizeof(Matrix4), projection_matrix.inner);
-        }
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
-
+        matrices_ = {view_matrix.transposed(), projection_matrix};
         position_ = rotation_matrix * Vector3 {0, 0, distance_};
     }
 
+    void Camera::bind(FrameRing& ring) const { ring.bindUniform(view_id_, matrices_); }
+
+    Matrix4 Camera::viewProjection() const
+    {
+        auto const& [view, projection] = matrices_;
+        return projection.transposed() * view.transposed();
+    }
+
     Matrix4 Camera::rotationMatrix(Vector2 const drag_delta) const
     {
         if (auto const rotation = fullRotation(drag_delta); auto const mat = std::get_if<Matrix4>(&rotation))
@@ -3,6 +3,8 @@
 #include <variant>
 #include <GL/glew.h>
 
+#include "Bounds.h"
+#include "FrameRing.h"
 #include "../Math/Matrix.h"
 #include "../Math/Quaternion.h"
 #include "../Math/Vector.h"
@@ -18,25 +20,24 @@ namespace render
         using Rotation = std::variant<Matrix4, Quaternion>;
 
     private:
-        GLuint cam_matrices_id_;
+        // Contents of the CameraMatrices block, column major like GL reads them.
+        struct Matrices
+        {
+            Matrix4 view, projection;
+        };
+
+        GLuint view_id_;
 
         Vector3  focus_;
         float    distance_;
         Rotation rotation_;
 
-        Vector3 position_ = {};
+        Vector3  position_ = {};
+        Matrices matrices_ = {Matrix4::identity(), Matrix4::identity()};
 
     public:
         Camera(float distance, Vector3 focus, GLuint view_id);
 
-        Camera(Camera const&)            = delete;
-        Camera& operator=(Camera const&) = delete;
-
-        Camera(Camera&& other) noexcept;
-        Camera& operator=(Camera&&) noexcept;
-
-        ~Camera();
-
         void swapRotationMode();
 
         void rotate(CameraController const& controller);
@@ -44,6 +45,11 @@ namespace render
 
         void update(callback::WindowSize size, Vector2 drag_delta, float zoom);
 
+        // Streams the matrices of the last update into the ring, for the draws of this frame.
+        void bind(FrameRing& ring) const;
+        // Of the last update, for culling what it does not show. Row major, unlike the matrices streamed to GL.
+        [[nodiscard]] Matrix4 viewProjection() const;
+
 
         [[nodiscard]] Vector3 position() const { return position_; }
     private:
@@ -6,6 +6,7 @@
 #include <GL/glew.h>
 
 
+#include "GlState.h"
 #include "../Callback.h"
 #include "../Config.h"
 
@@ -27,10 +28,11 @@ namespace render
         };
 
         auto const [width, height] = window.size;
+        auto&      state = GlState::current();
         GLuint     quad_buffer;
         // screen quad VAO
         glGenVertexArrays(1, &quad_id_);
-        glBindVertexArray(quad_id_);
+        state.bindVertexArray(quad_id_);
         {
             glGenBuffers(1, &quad_buffer);
             glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
@@ -49,16 +51,16 @@ namespace render
                 );
             }
         }
-        glBindVertexArray(0);
+        state.bindVertexArray(0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glDeleteBuffers(1, &quad_buffer);
 
         glGenFramebuffers(1, &fb_id_);
-        glBindFramebuffer(GL_FRAMEBUFFER, fb_id_);
+        state.bindFramebuffer(fb_id_);
         {
             // create a color attachment texture
             glGenTextures(1, &tex_id_);
-            glBindTexture(GL_TEXTURE_2D, tex_id_);
+            state.bindTexture(0, tex_id_);
             {
                 glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -80,7 +82,7 @@ namespace render
                 std::cerr << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
             #endif
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        state.bindFramebuffer(0);
     }
 
     Filter::Filter(Filter&& other) noexcept
@@ -108,6 +110,10 @@ namespace render
     {
         if (pipeline_ != nullptr)
         {
+            auto& state = GlState::current();
+            state.forgetVertexArray(quad_id_);
+            state.forgetFramebuffer(fb_id_);
+            state.forgetTexture(tex_id_);
             glDeleteVertexArrays(1, &quad_id_);
             glDeleteFramebuffers(1, &fb_id_);
             glDeleteRenderbuffers(1, &rb_id_);
@@ -120,8 +126,9 @@ namespace render
         // render
         // ------
         // bind to framebuffer and draw scene as we normally would to color texture 
-        glBindFramebuffer(GL_FRAMEBUFFER, fb_id_);
-        glEnable(GL_DEPTH_TEST); // enable depth testing (is disabled for rendering screen-space quad)
+        auto& state = GlState::current();
+        state.bindFramebuffer(fb_id_);
+        state.setEnabled(GL_DEPTH_TEST, true); // enable depth testing (is disabled for rendering screen-space quad)
 
         // make sure we clear the framebuffer's content
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -131,25 +138,28 @@ namespace render
     void Filter::finish()
     {
         // now bind back to default framebuffer and draw a quad plane with the attached framebuffer color texture
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glDisable(GL_DEPTH_TEST); // disable depth test so screen-space quad isn't discarded due to depth test.
+        auto& state = GlState::current();
+        state.bindFramebuffer(0);
+        // disable depth test so screen-space quad isn't discarded due to depth test.
+        state.setEnabled(GL_DEPTH_TEST, false);
         // clear all relevant buffers
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(pipeline_->programId());
+        state.useProgram(pipeline_->programId());
         //usar os shaders aqui
-        glBindVertexArray(quad_id_);
-        glBindTexture(GL_TEXTURE_2D, tex_id_); // use the color attachment texture as the texture of the quad plane
+        state.bindVertexArray(quad_id_);
+        state.bindTexture(0, tex_id_); // use the color attachment texture as the texture of the quad plane
         glDrawArrays(GL_TRIANGLES, 0, 6);
-        glUseProgram(0);
-        glEnable(GL_DEPTH_TEST);
+        // The scene's draws make their own program current, so only the depth test is left to restore.
+        state.setEnabled(GL_DEPTH_TEST, true);
     }
 
     void Filter::resize(callback::WindowSize const size)
     {
         auto const [width, height] = size;
-        glBindFramebuffer(GL_FRAMEBUFFER, fb_id_);
-        glBindTexture(GL_TEXTURE_2D, tex_id_);
+        auto&      state           = GlState::current();
+        state.bindFramebuffer(fb_id_);
+        state.bindTexture(0, tex_id_);
         {
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -162,6 +172,6 @@ namespace render
         }
         glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        state.bindFramebuffer(0);
     }
 }
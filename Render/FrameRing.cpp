@@ -0,0 +1,164 @@
+﻿#include "FrameRing.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace render
+{
+    namespace
+    {
+        constexpr GLbitfield  MapFlags         = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        constexpr GLuint64    WaitTimeout      = 1'000'000'000; // In nanoseconds, only bounds a single wait call.
+        constexpr std::size_t SegmentAlignment = 256;           // At least any offset alignment a binding asks for.
+
+        std::size_t alignUp(std::size_t const offset, std::size_t const alignment)
+        {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        bool signaled(GLsync const fence) { return glClientWaitSync(fence, 0, 0) != GL_TIMEOUT_EXPIRED; }
+
+        void waitFor(GLsync& fence)
+        {
+            if (fence == nullptr) return;
+
+            // Only the first wait flushes, the fence is on its way to the GPU after that.
+            auto flags = GLbitfield {GL_SYNC_FLUSH_COMMANDS_BIT};
+            while (glClientWaitSync(fence, flags, WaitTimeout) == GL_TIMEOUT_EXPIRED) { flags = 0; }
+            glDeleteSync(std::exchange(fence, nullptr));
+        }
+    }
+
+    FrameRing::FrameRing(std::size_t const segment_size)
+    {
+        if (!GLEW_ARB_buffer_storage)
+            throw std::runtime_error("Persistently mapped buffers need OpenGL 4.4 or ARB_buffer_storage.");
+
+        create(segment_size);
+    }
+
+    FrameRing::FrameRing(FrameRing&& other) noexcept
+        : buffer_ {std::exchange(other.buffer_, 0)},
+          mapping_ {std::exchange(other.mapping_, nullptr)},
+          segment_size_ {std::exchange(other.segment_size_, 0)},
+          segment_ {other.segment_},
+          used_ {other.used_},
+          peak_ {other.peak_},
+          fences_ {std::exchange(other.fences_, {})},
+          retired_ {std::move(other.retired_)}
+    {}
+
+    FrameRing& FrameRing::operator=(FrameRing&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+
+            buffer_       = std::exchange(other.buffer_, 0);
+            mapping_      = std::exchange(other.mapping_, nullptr);
+            segment_size_ = std::exchange(other.segment_size_, 0);
+            segment_      = other.segment_;
+            used_         = other.used_;
+            peak_         = other.peak_;
+            fences_       = std::exchange(other.fences_, {});
+            retired_      = std::move(other.retired_);
+        }
+        return *this;
+    }
+
+    FrameRing::~FrameRing() { destroy(); }
+
+    void FrameRing::beginFrame()
+    {
+        segment_ = (segment_ + 1) % Frames;
+        used_    = 0;
+        waitFor(fences_[segment_]);
+
+        auto const done = std::partition(
+            retired_.begin(),
+            retired_.end(),
+            [](Retired const& retired) { return retired.fence == nullptr || !signaled(retired.fence); }
+        );
+        for (auto retired = done; retired != retired_.end(); ++retired)
+        {
+            glDeleteSync(retired->fence);
+            glDeleteBuffers(1, &retired->buffer);
+        }
+        retired_.erase(done, retired_.end());
+    }
+
+    void FrameRing::endFrame()
+    {
+        if (fences_[segment_] != nullptr) glDeleteSync(fences_[segment_]);
+        fences_[segment_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        for (auto& retired : retired_)
+            if (retired.fence == nullptr) retired.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    FrameRing::Slice FrameRing::allocate(std::size_t const size, std::size_t const alignment)
+    {
+        auto offset = alignUp(used_, alignment);
+        if (offset + size > segment_size_)
+        {
+            // Draws of this frame may still read the old buffer, and of earlier ones from any of its segments, so it
+            // is kept until this frame is done. The new buffer has not been used yet, so none of its segments is busy.
+            retired_.push_back({buffer_, nullptr});
+            for (auto& fence : fences_)
+                if (fence != nullptr) glDeleteSync(std::exchange(fence, nullptr));
+
+            create(std::max(segment_size_ * 2, size));
+            offset = 0;
+        }
+
+        used_ = offset + size;
+        peak_ = std::max(peak_, used_);
+
+        auto const position = segment_ * segment_size_ + offset;
+        return {mapping_ + position, buffer_, static_cast<GLintptr>(position)};
+    }
+
+    std::size_t FrameRing::segmentSize() const { return segment_size_; }
+    std::size_t FrameRing::peakUsage() const { return peak_; }
+
+    std::size_t FrameRing::uniformAlignment()
+    {
+        static auto const alignment = []
+        {
+            GLint value;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+            return static_cast<std::size_t>(value);
+        }();
+        return alignment;
+    }
+
+    void FrameRing::create(std::size_t const segment_size)
+    {
+        segment_size_ = alignUp(segment_size, std::max(SegmentAlignment, uniformAlignment()));
+
+        auto const size = static_cast<GLsizeiptr>(segment_size_ * Frames);
+        glGenBuffers(1, &buffer_);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+        {
+            glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, MapFlags);
+            mapping_ = static_cast<Ptr<std::byte>>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, MapFlags));
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        if (mapping_ == nullptr) throw std::runtime_error("Cannot map the frame ring's buffer.");
+    }
+
+    void FrameRing::destroy()
+    {
+        // Deleting a buffer unmaps it, and GL keeps it alive until the draws reading it are done.
+        for (auto const fence : fences_)
+            if (fence != nullptr) glDeleteSync(fence);
+        for (auto const& [buffer, fence] : retired_)
+        {
+            if (fence != nullptr) glDeleteSync(fence);
+            glDeleteBuffers(1, &buffer);
+        }
+        if (buffer_ != 0) glDeleteBuffers(1, &buffer_);
+    }
+}
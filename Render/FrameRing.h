@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "../Utils.h"
+
+namespace render
+{
+    // Buffer mapped once for good and split into one segment per frame in flight, which the CPU streams each frame's
+    // data into while the GPU still reads the previous frames' from the other segments. A fence placed at the end of
+    // every frame keeps a segment from being written again before the GPU is done with it. Draws and uniform blocks
+    // select their data by binding a slice of the buffer.
+    class FrameRing
+    {
+    public:
+        static constexpr std::size_t Frames = 3;
+
+        // Where an allocation is written, and where it is read from by the GPU.
+        struct Slice
+        {
+            Ptr<std::byte> data;
+            GLuint         buffer;
+            GLintptr       offset;
+        };
+
+    private:
+        // Buffer replaced by a larger one, deleted once the GPU is done with the frame that replaced it.
+        struct Retired
+        {
+            GLuint buffer;
+            GLsync fence;
+        };
+
+        GLuint         buffer_       = 0;
+        Ptr<std::byte> mapping_      = nullptr;
+        std::size_t    segment_size_ = 0;
+        std::size_t    segment_      = 0;
+        std::size_t    used_         = 0;
+        std::size_t    peak_         = 0;
+
+        std::array<GLsync, Frames> fences_ {};
+        std::vector<Retired>       retired_;
+
+    public:
+        explicit FrameRing(std::size_t segment_size);
+
+        FrameRing(FrameRing const&)            = delete;
+        FrameRing& operator=(FrameRing const&) = delete;
+
+        FrameRing(FrameRing&& other) noexcept;
+        FrameRing& operator=(FrameRing&& other) noexcept;
+
+        ~FrameRing();
+
+        // Moves on to the next segment, waiting for the GPU to finish the frame that last used it.
+        void beginFrame();
+        // Fences the frame's draws, must follow the last draw reading this frame's data.
+        void endFrame();
+
+        // Room for size bytes in this frame's segment. A frame outgrowing its segment moves to a larger buffer, which
+        // leaves slices already bound where they are, so every slice must be bound with its own buffer.
+        [[nodiscard]] Slice allocate(std::size_t size, std::size_t alignment);
+
+        // Copies the value in and binds it to the uniform block binding, which std140 blocks of its layout read.
+        template <class T>
+        void bindUniform(GLuint const binding, T const& value)
+        {
+            auto const slice = allocate(sizeof(T), uniformAlignment());
+            std::memcpy(slice.data, &value, sizeof(T));
+            glBindBufferRange(GL_UNIFORM_BUFFER, binding, slice.buffer, slice.offset, sizeof(T));
+        }
+
+        [[nodiscard]] std::size_t segmentSize() const;
+        // Most bytes a single frame has used so far.
+        [[nodiscard]] std::size_t peakUsage() const;
+
+    private:
+        [[nodiscard]] static std::size_t uniformAlignment();
+
+        void create(std::size_t segment_size);
+        void destroy();
+    };
+}
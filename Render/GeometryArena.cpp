@@ -0,0 +1,221 @@
+﻿#include "GeometryArena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#include "GlState.h"
+
+namespace render
+{
+    namespace
+    {
+        constexpr std::size_t InitialVertices = std::size_t {1} << 16; // Per pool.
+        constexpr std::size_t InitialIndices  = std::size_t {1} << 18;
+        constexpr GLuint      VertexBinding   = 0;
+
+        std::vector<GLuint> widenIndices(MeshBuffers const& buffers)
+        {
+            auto const count = static_cast<std::size_t>(buffers.description.index_count);
+
+            std::vector<GLuint> indices(count);
+            if (buffers.description.index_type == GL_UNSIGNED_INT)
+            {
+                std::memcpy(indices.data(), buffers.indices.data, count * sizeof(GLuint));
+                return indices;
+            }
+
+            std::vector<GLushort> narrow(count);
+            std::memcpy(narrow.data(), buffers.indices.data, count * sizeof(GLushort));
+            std::copy(narrow.begin(), narrow.end(), indices.begin());
+            return indices;
+        }
+
+        // A buffer of the new size holding what the old one held, which is deleted.
+        GLuint moveToLarger(GLuint const old_buffer, std::size_t const old_size, std::size_t const new_size)
+        {
+            GLuint buffer;
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(new_size), nullptr, GL_STATIC_DRAW);
+            if (old_buffer != 0)
+            {
+                glBindBuffer(GL_COPY_READ_BUFFER, old_buffer);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(old_size));
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+                glDeleteBuffers(1, &old_buffer);
+            }
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            return buffer;
+        }
+
+        void upload(GLuint const buffer, std::size_t const offset, void const* const data, std::size_t const size)
+        {
+            if (size == 0) return;
+
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+    }
+
+    std::optional<std::size_t> GeometryArena::FreeList::allocate(std::size_t const size)
+    {
+        if (size == 0) return 0;
+
+        auto const range = std::find_if(
+            free_.begin(),
+            free_.end(),
+            [size](auto const& free) { return free.second >= size; }
+        );
+        if (range == free_.end()) return std::nullopt;
+
+        auto const [offset, free_size] = *range;
+        free_.erase(range);
+        if (free_size > size) free_.emplace(offset + size, free_size - size);
+        return offset;
+    }
+
+    void GeometryArena::FreeList::release(std::size_t offset, std::size_t size)
+    {
+        if (size == 0) return;
+
+        auto next = free_.lower_bound(offset);
+        if (next != free_.begin())
+        {
+            if (auto const previous = std::prev(next); previous->first + previous->second == offset)
+            {
+                offset = previous->first;
+                size += previous->second;
+                free_.erase(previous);
+            }
+        }
+        if (next != free_.end() && offset + size == next->first)
+        {
+            size += next->second;
+            free_.erase(next);
+        }
+        free_.emplace(offset, size);
+    }
+
+    void GeometryArena::FreeList::grow(std::size_t const capacity)
+    {
+        release(capacity_, capacity - capacity_);
+        capacity_ = capacity;
+    }
+
+    std::size_t GeometryArena::FreeList::capacity() const { return capacity_; }
+
+    GeometryArena& GeometryArena::current()
+    {
+        static GeometryArena arena;
+        return arena;
+    }
+
+    GeometryArena::Allocation GeometryArena::allocate(
+        std::uint32_t const format,
+        GLsizei const       stride,
+        FormatSetup const&  setup,
+        MeshBuffers const&  buffers
+    )
+    {
+        auto const& description = buffers.description;
+        auto const  vertex_size = static_cast<std::size_t>(stride);
+        auto const  vertices    = static_cast<std::size_t>(description.vertex_count);
+        if (buffers.vertex_streams.empty() || buffers.vertex_streams.front().size != vertices * vertex_size)
+            throw std::invalid_argument("Meshes in the geometry arena must have their vertices in a single stream.");
+
+        auto& destination = pool(format, stride, setup);
+        auto  base_vertex = destination.vertices.allocate(vertices);
+        if (!base_vertex)
+        {
+            auto const capacity = destination.vertices.capacity();
+            growVertices(destination, std::max(capacity * 2, capacity + vertices));
+            base_vertex = destination.vertices.allocate(vertices);
+        }
+
+        auto const indices     = widenIndices(buffers);
+        auto       first_index = indices_.allocate(indices.size());
+        if (!first_index)
+        {
+            growIndices(std::max(indices_.capacity() * 2, indices_.capacity() + indices.size()));
+            first_index = indices_.allocate(indices.size());
+        }
+
+        auto const vertex_data = buffers.vertex_streams.front().data;
+        upload(destination.buffer, *base_vertex * vertex_size, vertex_data, vertices * vertex_size);
+        upload(index_buffer_, *first_index * sizeof(GLuint), indices.data(), indices.size() * sizeof(GLuint));
+        return {
+            static_cast<std::uint32_t>(&destination - pools_.data()),
+            static_cast<GLint>(*base_vertex),
+            description.vertex_count,
+            static_cast<GLuint>(*first_index),
+            description.index_count
+        };
+    }
+
+    void GeometryArena::release(Allocation const& allocation)
+    {
+        auto const [pool, base_vertex, vertex_count, first_index, index_count] = allocation;
+        pools_[pool].vertices.release(static_cast<std::size_t>(base_vertex), static_cast<std::size_t>(vertex_count));
+        indices_.release(first_index, static_cast<std::size_t>(index_count));
+    }
+
+    GLuint GeometryArena::vaoOf(Allocation const& allocation) const { return pools_[allocation.pool].vao; }
+    GLuint GeometryArena::vertexBufferOf(Allocation const& allocation) const { return pools_[allocation.pool].buffer; }
+    GLuint GeometryArena::indexBuffer() const { return index_buffer_; }
+
+    GeometryArena::Pool& GeometryArena::pool(std::uint32_t const format, GLsizei const stride, FormatSetup const& setup)
+    {
+        auto const found = std::find_if(
+            pools_.begin(),
+            pools_.end(),
+            [format](Pool const& pool) { return pool.format == format; }
+        );
+        if (found != pools_.end()) return *found;
+
+        if (index_buffer_ == 0) growIndices(InitialIndices);
+
+        auto& pool = pools_.emplace_back(Pool {format, stride, 0, 0, {}});
+        glGenVertexArrays(1, &pool.vao);
+
+        auto& state = GlState::current();
+        state.bindVertexArray(pool.vao);
+        setup();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+        state.bindVertexArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        growVertices(pool, InitialVertices);
+        return pool;
+    }
+
+    void GeometryArena::growVertices(Pool& pool, std::size_t const capacity)
+    {
+        auto const stride = static_cast<std::size_t>(pool.stride);
+        pool.buffer       = moveToLarger(pool.buffer, pool.vertices.capacity() * stride, capacity * stride);
+        pool.vertices.grow(capacity);
+
+        auto& state = GlState::current();
+        state.bindVertexArray(pool.vao);
+        glBindVertexBuffer(VertexBinding, pool.buffer, 0, pool.stride);
+        state.bindVertexArray(0);
+    }
+
+    void GeometryArena::growIndices(std::size_t const capacity)
+    {
+        index_buffer_ = moveToLarger(index_buffer_, indices_.capacity() * sizeof(GLuint), capacity * sizeof(GLuint));
+        indices_.grow(capacity);
+
+        // The element buffer binding is part of the VAO state, so every pool's must be replaced.
+        auto& state = GlState::current();
+        for (auto const& pool : pools_)
+        {
+            state.bindVertexArray(pool.vao);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+        }
+        state.bindVertexArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
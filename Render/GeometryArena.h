@@ -0,0 +1,98 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "MeshCache.h"
+
+namespace render
+{
+    // Vertex and index buffers shared by every mesh placed in them, which are reduced to where their data starts.
+    // Meshes of the same vertex format share a pool with a single VAO, so draws of different meshes need no state
+    // change in between and can be submitted by a single multi-draw call. Indices are always 32 bit and relative to
+    // the mesh's first vertex, which draws pass as their base vertex.
+    //
+    // Space is handed out first fit from free lists, and a pool that runs out moves to buffers twice as large, which
+    // keeps the offsets it handed out. Meshes that draw from it must be deleted before the GL context.
+    class GeometryArena
+    {
+    public:
+        // Sets the attribute formats of a pool's VAO while it is bound, with the vertices read from binding 0.
+        using FormatSetup = std::function<void()>;
+
+        // Where a mesh's data is, in vertices and indices from the start of its pool's buffers.
+        struct Allocation
+        {
+            std::uint32_t pool;
+            GLint         base_vertex;
+            GLsizei       vertex_count;
+            GLuint        first_index;
+            GLsizei       index_count;
+        };
+
+    private:
+        // Free ranges of a buffer, in elements, keyed by where they start and merged with their neighbours.
+        class FreeList
+        {
+            std::map<std::size_t, std::size_t> free_;
+            std::size_t                        capacity_ = 0;
+
+        public:
+            [[nodiscard]] std::optional<std::size_t> allocate(std::size_t size);
+            void                                     release(std::size_t offset, std::size_t size);
+            // Adds the room between the old capacity and the new one.
+            void grow(std::size_t capacity);
+
+            [[nodiscard]] std::size_t capacity() const;
+        };
+
+        struct Pool
+        {
+            std::uint32_t format;
+            GLsizei       stride;
+            GLuint        vao;
+            GLuint        buffer = 0;
+            FreeList      vertices;
+        };
+
+        std::vector<Pool> pools_;
+        GLuint            index_buffer_ = 0;
+        FreeList          indices_;
+
+        GeometryArena() = default;
+
+    public:
+        GeometryArena(GeometryArena const&)            = delete;
+        GeometryArena& operator=(GeometryArena const&) = delete;
+
+        // There is a single GL context, and its buffers are released along with it.
+        static GeometryArena& current();
+
+        // Copies the mesh's vertices, which are all in the first stream, and its indices into the pool of the format,
+        // which is created the first time with the stride and attribute formats given.
+        [[nodiscard]] Allocation allocate(
+            std::uint32_t      format,
+            GLsizei            stride,
+            FormatSetup const& setup,
+            MeshBuffers const& buffers
+        );
+        void release(Allocation const& allocation);
+
+        [[nodiscard]] GLuint vaoOf(Allocation const& allocation) const;
+        [[nodiscard]] GLuint vertexBufferOf(Allocation const& allocation) const;
+        [[nodiscard]] GLuint indexBuffer() const;
+
+    private:
+        [[nodiscard]] Pool& pool(std::uint32_t format, GLsizei stride, FormatSetup const& setup);
+
+        // Moves the vertices or indices to a buffer of the new capacity, rebinding it to the pools' VAOs.
+        void growVertices(Pool& pool, std::size_t capacity);
+        void growIndices(std::size_t capacity);
+    };
+}
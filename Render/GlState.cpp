@@ -0,0 +1,165 @@
+﻿#include "GlState.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace render
+{
+    GlState& GlState::current()
+    {
+        static GlState state;
+        return state;
+    }
+
+    void GlState::useProgram(GLuint const program)
+    {
+        if (!changed(program_, program)) return;
+
+        glUseProgram(program);
+        program_uniforms_ = &uniforms_[program];
+    }
+
+    void GlState::bindVertexArray(GLuint const vertex_array)
+    {
+        if (changed(vertex_array_, vertex_array)) glBindVertexArray(vertex_array);
+    }
+
+    void GlState::bindFramebuffer(GLuint const framebuffer)
+    {
+        if (changed(framebuffer_, framebuffer)) glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+
+    void GlState::bindTexture(GLuint const unit, GLuint const texture)
+    {
+        if (unit >= textures_.size()) textures_.resize(unit + 1, Unknown);
+        if (textures_[unit] == texture)
+        {
+            frame_.skipped++;
+            return;
+        }
+
+        if (changed(active_unit_, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+        textures_[unit] = texture;
+        frame_.issued++;
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+
+    void GlState::setEnabled(GLenum const capability, bool const enabled)
+    {
+        auto const [shadow, added] = capabilities_.try_emplace(capability, enabled);
+        if (!added && shadow->second == enabled)
+        {
+            frame_.skipped++;
+            return;
+        }
+
+        shadow->second = enabled;
+        frame_.issued++;
+        if (enabled) glEnable(capability);
+        else glDisable(capability);
+    }
+
+    void GlState::uniform(GLint const location, GLint const value)
+    {
+        // Stored bit for bit among the floats, only ever compared with what was stored at the same location.
+        GLfloat bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        if (changed(location, &bits, 1)) glUniform1i(location, value);
+    }
+
+    void GlState::uniform(GLint const location, GLfloat const value)
+    {
+        if (changed(location, &value, 1)) glUniform1f(location, value);
+    }
+
+    void GlState::uniform(GLint const location, Vector3 const value)
+    {
+        GLfloat const values[] = {value.x, value.y, value.z};
+        if (changed(location, values, 3)) glUniform3f(location, value.x, value.y, value.z);
+    }
+
+    void GlState::uniform(GLint const location, Vector4 const value)
+    {
+        GLfloat const values[] = {value.x, value.y, value.z, value.w};
+        if (changed(location, values, 4)) glUniform4f(location, value.x, value.y, value.z, value.w);
+    }
+
+    void GlState::uniform(GLint const location, Matrix4 const& value)
+    {
+        if (changed(location, value.inner, Matrix4::Len)) glUniformMatrix4fv(location, 1, GL_TRUE, value.inner);
+    }
+
+    void GlState::uniform(GLint const location, Ptr<Vector4 const> const values, GLsizei const count)
+    {
+        if (changed(location, &values->x, count * 4)) glUniform4fv(location, count, &values->x);
+    }
+
+    void GlState::forgetProgram(GLuint const program)
+    {
+        // A deleted program stays in use until another one is, so only its uniforms are forgotten.
+        uniforms_.erase(program);
+        if (program_ == program) program_uniforms_ = &uniforms_[program];
+    }
+
+    void GlState::forgetVertexArray(GLuint const vertex_array)
+    {
+        if (vertex_array_ == vertex_array) vertex_array_ = 0;
+    }
+
+    void GlState::forgetFramebuffer(GLuint const framebuffer)
+    {
+        if (framebuffer_ == framebuffer) framebuffer_ = 0;
+    }
+
+    void GlState::forgetTexture(GLuint const texture)
+    {
+        std::replace(textures_.begin(), textures_.end(), texture, GLuint {0});
+    }
+
+    void GlState::endFrame()
+    {
+        last_frame_ = frame_;
+        frame_      = {0, 0};
+    }
+
+    GlState::Counts GlState::lastFrame() const { return last_frame_; }
+
+    bool GlState::changed(GLint const location, Ptr<GLfloat const> const values, GLsizei const size)
+    {
+        if (location < 0) return false;
+        if (program_uniforms_ == nullptr)
+        {
+            // No program was put in use through here, so there is nothing to compare with.
+            frame_.issued++;
+            return true;
+        }
+
+        auto& program_uniforms = *program_uniforms_;
+        if (static_cast<std::size_t>(location) >= program_uniforms.size()) program_uniforms.resize(location + 1);
+
+        auto& shadow = program_uniforms[location];
+        if (shadow.size == size && std::memcmp(shadow.values.data(), values, size * sizeof(GLfloat)) == 0)
+        {
+            frame_.skipped++;
+            return false;
+        }
+
+        shadow.values.assign(values, values + size);
+        shadow.size = size;
+        frame_.issued++;
+        return true;
+    }
+
+    bool GlState::changed(GLuint& shadow, GLuint const value)
+    {
+        if (shadow == value)
+        {
+            frame_.skipped++;
+            return false;
+        }
+
+        shadow = value;
+        frame_.issued++;
+        return true;
+    }
+}
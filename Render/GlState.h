@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "../Math/Matrix.h"
+#include "../Utils.h"
+
+namespace render
+{
+    // Shadow of the GL state the renderer changes, so that calls setting what is already set are skipped instead of
+    // reaching the driver. It only stays right if every change to the state it tracks goes through it, and if deleted
+    // programs, VAOs, textures and framebuffers are forgotten here, since GL hands their names out again.
+    class GlState
+    {
+    public:
+        struct Counts
+        {
+            std::uint64_t issued;  // Calls that reached GL.
+            std::uint64_t skipped; // Calls that would not have changed anything.
+        };
+
+    private:
+        static constexpr GLuint Unknown = ~GLuint {0};
+
+        struct Uniform
+        {
+            std::vector<GLfloat> values; // Keeps its capacity, so only the first value set at a location allocates.
+            GLsizei              size = 0; // Nothing was set yet when 0.
+        };
+
+        GLuint              program_      = Unknown;
+        GLuint              vertex_array_ = Unknown;
+        GLuint              framebuffer_  = Unknown;
+        GLuint              active_unit_  = Unknown;
+        std::vector<GLuint> textures_; // 2D texture bound to each unit.
+
+        std::unordered_map<GLenum, bool>                  capabilities_;
+        std::unordered_map<GLuint, std::vector<Uniform>> uniforms_; // Per program, indexed by location.
+        OptPtr<std::vector<Uniform>>                      program_uniforms_ = nullptr;
+
+        Counts frame_      = {0, 0};
+        Counts last_frame_ = {0, 0};
+
+        GlState() = default;
+
+    public:
+        GlState(GlState const&)            = delete;
+        GlState& operator=(GlState const&) = delete;
+
+        // There is a single GL context, created before anything is drawn and used only from the main thread.
+        static GlState& current();
+
+        void useProgram(GLuint program);
+        void bindVertexArray(GLuint vertex_array);
+        void bindFramebuffer(GLuint framebuffer);
+        void bindTexture(GLuint unit, GLuint texture); // As GL_TEXTURE_2D.
+        void setEnabled(GLenum capability, bool enabled);
+
+        // Uniforms of the program in use. Locations of -1, of uniforms the program does not have, are ignored.
+        void uniform(GLint location, GLint value);
+        void uniform(GLint location, GLfloat value);
+        void uniform(GLint location, Vector3 value);
+        void uniform(GLint location, Vector4 value);
+        void uniform(GLint location, Matrix4 const& value); // Row major, like every matrix here.
+        void uniform(GLint location, Ptr<Vector4 const> values, GLsizei count); // An array of count vectors.
+
+        void forgetProgram(GLuint program);
+        void forgetVertexArray(GLuint vertex_array);
+        void forgetFramebuffer(GLuint framebuffer);
+        void forgetTexture(GLuint texture);
+
+        // Starts counting a new frame, keeping the counts of the one that ended.
+        void endFrame();
+        [[nodiscard]] Counts lastFrame() const;
+
+    private:
+        // Whether the value differs from the one last set at the location, recording it if so.
+        [[nodiscard]] bool changed(GLint location, Ptr<GLfloat const> values, GLsizei size);
+        [[nodiscard]] bool changed(GLuint& shadow, GLuint value);
+    };
+}
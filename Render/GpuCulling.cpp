@@ -0,0 +1,91 @@
+﻿#include "GpuCulling.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "GlState.h"
+
+namespace render
+{
+    GpuCulling::GpuCulling(Shader compute)
+        : program_ {false, std::move(compute)},
+          planes_id_ {glGetUniformLocation(program_.programId(), "Planes")},
+          object_count_id_ {glGetUniformLocation(program_.programId(), "ObjectCount")}
+    {
+        if (!GLEW_ARB_compute_shader || !GLEW_ARB_shader_storage_buffer_object)
+            throw std::runtime_error("Culling on the GPU needs OpenGL 4.3 or compute shaders and storage buffers.");
+
+        GLint alignment;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        storage_alignment_ = static_cast<std::size_t>(alignment);
+    }
+
+    void GpuCulling::setFrustum(Frustum const& frustum) { planes_ = frustum.planes(); }
+
+    GpuCulling::Culled GpuCulling::cull(
+        FrameRing&                 ring,
+        std::vector<Object> const& objects,
+        std::size_t const          draw_count
+    )
+    {
+        auto const objects_size  = objects.size() * sizeof(Object);
+        auto const commands_size = objects.size() * sizeof(DrawCommand);
+        auto const counters_size = draw_count * sizeof(GLuint);
+
+        auto const input = ring.allocate(objects_size, storage_alignment_);
+        auto const culled = Culled {
+            ring.allocate(commands_size, storage_alignment_),
+            ring.allocate(counters_size, storage_alignment_)
+        };
+        if (objects.empty()) return culled;
+
+        // The shader only writes the commands of visible objects, and counts from zero.
+        std::memcpy(input.data, objects.data(), objects_size);
+        std::memset(culled.commands.data, 0, commands_size);
+        std::memset(culled.counters.data, 0, counters_size);
+
+        auto const bind = [](GLuint const binding, FrameRing::Slice const slice, std::size_t const size)
+        {
+            auto const bytes = static_cast<GLsizeiptr>(size);
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, slice.buffer, slice.offset, bytes);
+        };
+        bind(ObjectBinding, input, objects_size);
+        bind(CommandBinding, culled.commands, commands_size);
+        bind(CounterBinding, culled.counters, counters_size);
+
+        auto& state = GlState::current();
+        state.useProgram(program_.programId());
+        state.uniform(object_count_id_, static_cast<GLint>(objects.size()));
+        state.uniform(planes_id_, planes_.data(), static_cast<GLsizei>(planes_.size()));
+
+        auto const groups = (objects.size() + GroupSize - 1) / GroupSize;
+        glDispatchCompute(static_cast<GLuint>(groups), 1, 1);
+
+        // Both the commands and their counts are read by the draws.
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+        return culled;
+    }
+
+    void GpuCulling::draw(
+        Culled const&     culled,
+        std::size_t const draw,
+        std::size_t const first_object,
+        std::size_t const object_count
+    )
+    {
+        auto const first     = culled.commands.offset + static_cast<GLintptr>(first_object * sizeof(DrawCommand));
+        auto const commands  = reinterpret_cast<void const*>(first);
+        auto const max_count = static_cast<GLsizei>(object_count);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culled.commands.buffer);
+        if (GLEW_ARB_indirect_parameters)
+        {
+            glBindBuffer(GL_PARAMETER_BUFFER_ARB, culled.counters.buffer);
+            auto const count = culled.counters.offset + static_cast<GLintptr>(draw * sizeof(GLuint));
+            glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, commands, count, max_count, 0);
+            glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+        }
+        else glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, commands, max_count, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+}
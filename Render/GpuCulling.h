@@ -0,0 +1,77 @@
+﻿#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Bounds.h"
+#include "FrameRing.h"
+#include "Shader.h"
+#include "../Math/Vector.h"
+
+namespace render
+{
+    // Layout glMultiDrawElementsIndirect reads its commands in.
+    struct DrawCommand
+    {
+        GLuint count, instance_count, first_index;
+        GLint  base_vertex;
+        GLuint base_instance;
+    };
+
+    // Frustum culling of the objects of multi-draws by a compute shader, so that the CPU only hands over their bounds.
+    // Every object is tested by an invocation of its own, which appends a command drawing it to those of its
+    // multi-draw when it is visible. The commands of each multi-draw are compacted through an atomic counter, which
+    // the draw reads as its command count where ARB_indirect_parameters is supported. Elsewhere the commands past the
+    // counter are left zeroed and drawn as nothing.
+    class GpuCulling
+    {
+    public:
+        // Storage buffer bindings of the shader.
+        static constexpr GLuint ObjectBinding  = 0;
+        static constexpr GLuint CommandBinding = 1;
+        static constexpr GLuint CounterBinding = 2;
+
+        static constexpr GLuint GroupSize = 64; // Invocations per work group, the shader's local size.
+
+        // Object as the shader reads it, with the std430 layout.
+        struct Object
+        {
+            Vector4 center; // Of its bounds in world space, in xyz.
+            Vector4 extent;
+            GLuint  count, first_index; // Of the command that draws it.
+            GLint   base_vertex;
+            GLuint  instance;      // Drawn as its base instance, where its instance attributes are.
+            GLuint  draw;          // Multi-draw it belongs to, whose commands start at first_command.
+            GLuint  first_command;
+            GLuint  padding[2];    // Up to the 16 byte alignment std430 gives the struct.
+        };
+
+        // Where the commands of the visible objects were written.
+        struct Culled
+        {
+            FrameRing::Slice commands; // One for each object, with those of a multi-draw in the order of its objects.
+            FrameRing::Slice counters; // Visible objects of each multi-draw.
+        };
+
+    private:
+        Pipeline               program_;
+        GLint                  planes_id_, object_count_id_;
+        std::array<Vector4, 6> planes_ {};
+        std::size_t            storage_alignment_;
+
+    public:
+        explicit GpuCulling(Shader compute);
+
+        // Of the frame the next objects are culled for.
+        void setFrustum(Frustum const& frustum);
+
+        // Culls the objects of draw_count multi-draws, whose commands and counters live in the ring for the frame.
+        [[nodiscard]] Culled cull(FrameRing& ring, std::vector<Object> const& objects, std::size_t draw_count);
+
+        // Issues the multi-draw, whose objects are object_count from first_object on, with its VAO and program bound.
+        static void draw(Culled const& culled, std::size_t draw, std::size_t first_object, std::size_t object_count);
+    };
+}
@@ -1,114 +1,1001 @@
 ﻿#include "Mesh.h"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <sstream>
-#include <string>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 
+#include "GlState.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include "Shader.h"
+#include "../Engine/AssetPack.h"
+#include "../Engine/JobSystem.h"
+#include "../Engine/MappedFile.h"
 
 namespace render
 {
     namespace
     {
-        void parseLine(std::istringstream& line, MeshLoader& mesh)
+        using Cursor = Ptr<char const>;
+
+        bool isBlank(char const c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+        void skipBlanks(Cursor& it, Cursor const end)
+        {
+            while (it != end && isBlank(*it)) ++it;
+        }
+
+        std::string_view nextToken(Cursor& it, Cursor const end)
+        {
+            skipBlanks(it, end);
+            auto const start = it;
+            while (it != end && !isBlank(*it)) ++it;
+            return {start, static_cast<std::size_t>(it - start)};
+        }
+
+        float parseFloat(Cursor& it, Cursor const end)
         {
-            std::string s;
-            line >> s;
-            if (s == "v") mesh.parseVec(line);
-            else if (s == "vt") mesh.parseTex(line);
-            else if (s == "vn") mesh.parseNorm(line);
-            else if (s == "f") mesh.parseFace(line);
+            skipBlanks(it, end);
+            if (it != end && *it == '+') ++it;
+
+            float value;
+            auto const [next, error] = std::from_chars(it, end, value);
+            if (error != std::errc {})
+                throw std::invalid_argument("Malformed number in mesh file.");
+            it = next;
+            return value;
         }
 
-        MeshLoader parseMeshFile(std::ifstream& in)
+        // A line-aligned slice of the source, parsed independently of the other slices.
+        struct MeshChunk
+        {
+            std::string_view source;
+            MeshLoader       mesh;
+
+            // Positions in the id arrays of negative indices, which were resolved against the chunk's own elements
+            // and still need the elements of the preceding chunks added when merging.
+            std::vector<std::size_t> relative_verts, relative_texs, relative_norms;
+        };
+
+        void parseIndex(
+            Cursor&                   it,
+            Cursor const              end,
+            std::vector<GLsizei>&     ids,
+            std::size_t const         count,
+            std::vector<std::size_t>& relative
+        )
         {
-            MeshLoader  mesh;
-            std::string line;
-            while (std::getline(in, line))
+            GLsizei value;
+            auto const [next, error] = std::from_chars(it, end, value);
+            if (error != std::errc {})
+                throw std::invalid_argument("Malformed face index in mesh file.");
+            it = next;
+
+            if (value < 0)
             {
-                std::istringstream line_in(line);
-                parseLine(line_in, mesh);
+                relative.push_back(ids.size());
+                value += static_cast<GLsizei>(count) + 1;
             }
-            return mesh;
+            ids.push_back(value);
         }
 
-        GLuint createVao(MeshLoader const& mesh)
+        // Face corners come in the forms `v`, `v/vt`, `v//vn` and `v/vt/vn`.
+        void parseCorner(Cursor& it, Cursor const end, MeshChunk& chunk)
         {
-            auto const vert_count = mesh.size();
+            auto& mesh = chunk.mesh;
 
-            GLuint vao_id, vbo_vt, vbo_tx, vbo_n;
+            skipBlanks(it, end);
+            parseIndex(it, end, mesh.vert_ids, mesh.vertices.size(), chunk.relative_verts);
+            if (it == end || *it != '/') return;
 
-            std::vector<Vector3> vs;
-            std::vector<Vector2> ts;
-            std::vector<Vector3> ns;
+            if (++it != end && *it != '/')
+            {
+                parseIndex(it, end, mesh.tex_ids, mesh.tex_coords.size(), chunk.relative_texs);
+                mesh.has_textures = true;
+            }
+            if (it == end || *it != '/') return;
 
-            vs.reserve(vert_count);
-            for (auto const vert_id : mesh.vert_ids)
-                vs.push_back(mesh.vertices[vert_id - 1]);
+            ++it;
+            parseIndex(it, end, mesh.norm_ids, mesh.normals.size(), chunk.relative_norms);
+            mesh.has_normals = true;
+        }
 
-            if (mesh.has_textures)
+        void parseLine(Cursor it, Cursor const end, MeshChunk& chunk)
+        {
+            auto& mesh = chunk.mesh;
+
+            auto const kind = nextToken(it, end);
+            if (kind == "v")
+            {
+                auto const x = parseFloat(it, end);
+                auto const y = parseFloat(it, end);
+                auto const z = parseFloat(it, end);
+                mesh.vertices.push_back(Vector3 {x, y, z});
+            }
+            else if (kind == "vt")
+            {
+                auto const u = parseFloat(it, end);
+                auto const v = parseFloat(it, end);
+                mesh.tex_coords.push_back(Vector2 {u, v});
+            }
+            else if (kind == "vn")
             {
-                ts.reserve(vert_count);
-                for (auto const tex_id : mesh.tex_ids)
-                    ts.push_back(mesh.tex_coords[tex_id - 1]);
+                auto const x = parseFloat(it, end);
+                auto const y = parseFloat(it, end);
+                auto const z = parseFloat(it, end);
+                mesh.normals.push_back(Vector3 {x, y, z});
             }
+            else if (kind == "f")
+            {
+                for (int i = 0; i < 3; i++)
+                    parseCorner(it, end, chunk);
+            }
+        }
 
-            if (mesh.has_normals)
+        // Tokenizes the chunk in place, one line at a time, without copying any of it.
+        void parseChunk(MeshChunk& chunk)
+        {
+            auto       it  = chunk.source.data();
+            auto const end = it + chunk.source.size();
+            while (it != end)
             {
-                ns.reserve(vert_count);
-                for (auto const norm_id : mesh.norm_ids)
-                    ns.push_back(mesh.normals[norm_id - 1]);
+                auto const eol      = static_cast<Cursor>(std::memchr(it, '\n', end - it));
+                auto const line_end = eol != nullptr ? eol : end;
+
+                parseLine(it, line_end, chunk);
+                it = eol != nullptr ? eol + 1 : end;
             }
+        }
 
-            glGenVertexArrays(1, &vao_id);
-            glBindVertexArray(vao_id);
+        std::vector<MeshChunk> splitChunks(std::string_view const source, OptPtr<engine::JobSystem> const jobs)
+        {
+            constexpr std::size_t MinChunkSize = 4 << 20;
+
+            auto const workers = jobs != nullptr ? std::max<std::size_t>(jobs->workerCount(), 1) : 1;
+            auto const count   = std::clamp<std::size_t>(source.size() / MinChunkSize, 1, workers);
+
+            std::vector<MeshChunk> chunks(count);
+
+            std::size_t start = 0;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                auto end = i + 1 == count ? source.size() : std::max(source.size() * (i + 1) / count, start);
+                if (end != source.size())
+                {
+                    auto const eol = source.find('\n', end);
+                    end            = eol == std::string_view::npos ? source.size() : eol + 1;
+                }
+                chunks[i].source = source.substr(start, end - start);
+                start            = end;
+            }
+            return chunks;
+        }
+
+        // Concatenates the chunks in source order, offsetting the relative indices of each chunk by the element
+        // counts of the chunks before it, so the result is exactly what a serial parse would produce.
+        MeshLoader mergeChunks(std::vector<MeshChunk>& chunks, engine::JobSystem& jobs)
+        {
+            if (chunks.size() == 1) return std::move(chunks.front().mesh);
+
+            struct Offsets
+            {
+                std::size_t vertices, tex_coords, normals, vert_ids, tex_ids, norm_ids;
+            };
+
+            std::vector<Offsets> offsets(chunks.size() + 1);
+            for (std::size_t i = 0; i < chunks.size(); i++)
+            {
+                auto const& mesh = chunks[i].mesh;
+                auto const& off  = offsets[i];
+
+                offsets[i + 1] = {
+                    off.vertices + mesh.vertices.size(),
+                    off.tex_coords + mesh.tex_coords.size(),
+                    off.normals + mesh.normals.size(),
+                    off.vert_ids + mesh.vert_ids.size(),
+                    off.tex_ids + mesh.tex_ids.size(),
+                    off.norm_ids + mesh.norm_ids.size()
+                };
+            }
+
+            MeshLoader merged;
+            {
+                auto const& total = offsets.back();
+                merged.vertices.resize(total.vertices);
+                merged.tex_coords.resize(total.tex_coords);
+                merged.normals.resize(total.normals);
+                merged.vert_ids.resize(total.vert_ids);
+                merged.tex_ids.resize(total.tex_ids);
+                merged.norm_ids.resize(total.norm_ids);
+            }
+
+            auto const place = [](auto const& from, auto& into, std::size_t const at)
+            {
+                std::copy(from.begin(), from.end(), into.begin() + at);
+            };
+
+            jobs.parallelFor(
+                chunks.size(),
+                1,
+                [&](std::size_t const i, std::size_t)
+                {
+                    auto const& [_, mesh, relative_verts, relative_texs, relative_norms] = chunks[i];
+                    auto const& off = offsets[i];
+
+                    place(mesh.vertices, merged.vertices, off.vertices);
+                    place(mesh.tex_coords, merged.tex_coords, off.tex_coords);
+                    place(mesh.normals, merged.normals, off.normals);
+                    place(mesh.vert_ids, merged.vert_ids, off.vert_ids);
+                    place(mesh.tex_ids, merged.tex_ids, off.tex_ids);
+                    place(mesh.norm_ids, merged.norm_ids, off.norm_ids);
+
+                    for (auto const pos : relative_verts)
+                        merged.vert_ids[off.vert_ids + pos] += static_cast<GLsizei>(off.vertices);
+                    for (auto const pos : relative_texs)
+                        merged.tex_ids[off.tex_ids + pos] += static_cast<GLsizei>(off.tex_coords);
+                    for (auto const pos : relative_norms)
+                        merged.norm_ids[off.norm_ids + pos] += static_cast<GLsizei>(off.normals);
+                }
+            );
+
+            for (auto const& chunk : chunks)
+            {
+                merged.has_textures |= chunk.mesh.has_textures;
+                merged.has_normals |= chunk.mesh.has_normals;
+            }
+            return merged;
+        }
+
+        // Large sources are split at line boundaries and parsed as a job per chunk, when there are jobs to run them.
+        MeshLoader parseMeshSource(std::string_view const source, OptPtr<engine::JobSystem> const jobs = nullptr)
+        {
+            auto chunks = splitChunks(source, jobs);
+            if (chunks.size() == 1)
+            {
+                parseChunk(chunks.front());
+                return std::move(chunks.front().mesh);
+            }
+
+            jobs->parallelFor(chunks.size(), 1, [&](std::size_t const i, std::size_t) { parseChunk(chunks[i]); });
+            return mergeChunks(chunks, *jobs);
+        }
+
+        // A face corner, i.e. the (v, vt, vn) triple of 1-based ids, with 0 for attributes the mesh does not have.
+        struct Corner
+        {
+            GLsizei vert, tex, norm;
+        };
+
+        bool operator==(Corner const& lhs, Corner const& rhs)
+        {
+            return lhs.vert == rhs.vert && lhs.tex == rhs.tex && lhs.norm == rhs.norm;
+        }
+
+        // Open-addressing map from each distinct corner to the index of the vertex it was first emitted as.
+        class CornerTable
+        {
+            constexpr static GLuint Empty = ~GLuint {0};
+
+            std::vector<Corner> keys_;
+            std::vector<GLuint> values_;
+            std::size_t         mask_;
+
+            static std::size_t hash(Corner const& corner)
+            {
+                auto h = static_cast<std::uint32_t>(corner.vert) * 0x9E3779B1u;
+                h ^= static_cast<std::uint32_t>(corner.tex) * 0x85EBCA77u;
+                h ^= static_cast<std::uint32_t>(corner.norm) * 0xC2B2AE3Du;
+                h ^= h >> 15;
+                h *= 0x2C1B3C6Du;
+                h ^= h >> 13;
+                return h;
+            }
+
+        public:
+            explicit CornerTable(std::size_t const max_entries)
+            {
+                std::size_t capacity = 16;
+                while (capacity < max_entries * 2) capacity <<= 1;
+
+                keys_.resize(capacity);
+                values_.assign(capacity, Empty);
+                mask_ = capacity - 1;
+            }
+
+            // Returns the index stored for the corner, storing `next` first if the corner was not seen before.
+            std::pair<GLuint, bool> insert(Corner const& corner, GLuint const next)
+            {
+                for (auto slot = hash(corner) & mask_;; slot = (slot + 1) & mask_)
+                {
+                    if (values_[slot] == Empty)
+                    {
+                        keys_[slot]   = corner;
+                        values_[slot] = next;
+                        return {next, true};
+                    }
+                    if (keys_[slot] == corner) return {values_[slot], false};
+                }
+            }
+        };
+
+        template <class T>
+        T const& fetch(std::vector<T> const& elements, GLsizei const id)
+        {
+            if (id < 1 || static_cast<std::size_t>(id) > elements.size())
+                throw std::out_of_range("Face index out of range in mesh.");
+            return elements[id - 1];
+        }
+
+        GLenum indexTypeFor(IndexedMesh const& mesh)
+        {
+            return mesh.vertexCount() <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        }
+
+        // Attributes of one vertex packed next to each other, for the interleaved layout.
+        struct Vertex
+        {
+            Vector3 position;
+            Vector2 tex_coord;
+            Vector3 normal;
+        };
+
+        std::vector<Vertex> interleave(IndexedMesh const& mesh)
+        {
+            std::vector<Vertex> vertices(mesh.positions.size(), Vertex {});
+            for (std::size_t i = 0; i < vertices.size(); i++)
+            {
+                vertices[i].position = mesh.positions[i];
+                if (mesh.has_textures) vertices[i].tex_coord = mesh.tex_coords[i];
+                if (mesh.has_normals) vertices[i].normal = mesh.normals[i];
+            }
+            return vertices;
+        }
+
+        template <class T>
+        ByteView bytesOf(std::vector<T> const& elements) { return {elements.data(), elements.size() * sizeof(T)}; }
+
+        GLuint uploadBuffer(GLenum const target, ByteView const bytes)
+        {
+            GLuint buffer_id;
+            glGenBuffers(1, &buffer_id);
+            glBindBuffer(target, buffer_id);
+            glBufferData(target, static_cast<GLsizeiptr>(bytes.size), bytes.data, GL_STATIC_DRAW);
+            return buffer_id;
+        }
+
+        void bindAttribute(
+            GLuint const      index,
+            GLint const       size,
+            GLenum const      type,
+            GLboolean const   normalized,
+            GLsizei const     stride,
+            std::size_t const offset
+        )
+        {
+            glEnableVertexAttribArray(index);
+            glVertexAttribPointer(index, size, type, normalized, stride, reinterpret_cast<void*>(offset));
+        }
+
+        void bindAttribute(GLuint const index, GLint const size, GLsizei const stride, std::size_t const offset)
+        {
+            bindAttribute(index, size, GL_FLOAT, GL_FALSE, stride, offset);
+        }
+
+        // Only the instanced programs read these, and they are only drawn with an instance buffer bound.
+        void bindInstanceAttributes()
+        {
+            auto const attribute = [](GLuint const index, GLint const size, std::size_t const offset)
+            {
+                glEnableVertexAttribArray(index);
+                glVertexAttribFormat(index, size, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offset));
+                glVertexAttribBinding(index, Mesh::InstanceBinding);
+            };
+
+            for (GLuint column = 0; column < 4; column++)
+                attribute(Pipeline::InstanceModel + column, 4, offsetof(Instance, model) + column * sizeof(Vector4));
+            attribute(Pipeline::InstanceColor, 4, offsetof(Instance, color));
+            attribute(Pipeline::InstanceAmbient, 3, offsetof(Instance, ambient_color));
+            attribute(Pipeline::InstanceSpecular, 3, offsetof(Instance, specular_color));
+            attribute(Pipeline::InstanceShininess, 1, offsetof(Instance, shininess));
+            glVertexBindingDivisor(Mesh::InstanceBinding, 1);
+        }
+
+        // Vertex of the packed format, 16 bytes instead of the 32 of the float format.
+        struct PackedVertex
+        {
+            std::int16_t  position[4];  // snorm16 relative to the mesh bounds, the 4th component is padding.
+            std::uint16_t tex_coord[2]; // unorm16, or half floats when a coordinate lies outside [0, 1].
+            std::uint32_t normal;       // snorm GL_INT_2_10_10_10_REV.
+        };
+
+        // Box the packed positions are relative to, kept non-degenerate so its matrix stays invertible.
+        struct Bounds
+        {
+            Vector3 center, half_extent;
+        };
+
+        Bounds boundsOf(std::vector<Vector3> const& positions)
+        {
+            if (positions.empty()) return {Vector3::filled(0), Vector3::filled(1)};
+
+            auto low = positions.front(), high = positions.front();
+            for (auto const [x, y, z] : positions)
+            {
+                low  = {std::min(low.x, x), std::min(low.y, y), std::min(low.z, z)};
+                high = {std::max(high.x, x), std::max(high.y, y), std::max(high.z, z)};
+            }
+
+            auto const nonZero = [](float const extent) { return extent > Epsilon ? extent : 1.f; };
+            auto const half    = (high - low) * 0.5f;
+            return {(low + high) * 0.5f, {nonZero(half.x), nonZero(half.y), nonZero(half.z)}};
+        }
+
+        bool usesUnitTexCoords(IndexedMesh const& mesh)
+        {
+            return std::all_of(
+                mesh.tex_coords.begin(),
+                mesh.tex_coords.end(),
+                [](Vector2 const uv) { return uv.x >= 0 && uv.x <= 1 && uv.y >= 0 && uv.y <= 1; }
+            );
+        }
+
+        std::int16_t toSnorm16(float const value)
+        {
+            return static_cast<std::int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+        }
+
+        std::uint16_t toUnorm16(float const value)
+        {
+            return static_cast<std::uint16_t>(std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
+        }
+
+        // Rounds to the nearest half float, flushing values too small for a normal half to zero.
+        std::uint16_t toHalf(float const value)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            auto const sign     = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+            auto const exponent = static_cast<int>((bits >> 23) & 0xFFu) - 127 + 15;
+            auto const mantissa = bits & 0x7FFFFFu;
+
+            if (exponent <= 0) return sign;
+            if (exponent >= 31) return sign | 0x7C00u;
+
+            auto half = static_cast<std::uint32_t>(sign | (exponent << 10) | (mantissa >> 13));
+            if (mantissa & 0x1000u) ++half;
+            return static_cast<std::uint16_t>(half);
+        }
+
+        float fromHalf(std::uint16_t const half)
+        {
+            auto const sign     = half & 0x8000u ? -1.f : 1.f;
+            auto const exponent = (half >> 10) & 0x1Fu;
+            auto const mantissa = static_cast<float>(half & 0x3FFu);
+
+            if (exponent == 0) return sign * std::ldexp(mantissa, -24);
+            if (exponent == 31) return sign * std::numeric_limits<float>::infinity();
+            return sign * std::ldexp(1024 + mantissa, static_cast<int>(exponent) - 25);
+        }
+
+        std::uint32_t toInt2101010(Vector3 const normal)
+        {
+            auto const component = [](float const value)
+            {
+                return static_cast<std::uint32_t>(std::lround(std::clamp(value, -1.f, 1.f) * 511.f)) & 0x3FFu;
+            };
+            return component(normal.x) | component(normal.y) << 10 | component(normal.z) << 20;
+        }
+
+        // Positions are stored relative to the bounds and decoded by the mesh's dequantization matrix, which is
+        // folded into the model matrix. The shaders derive the normal matrix from that model matrix, so normals are
+        // pre-scaled by the bounds to cancel the inverse scale it introduces.
+        std::vector<PackedVertex> pack(IndexedMesh const& mesh, Bounds const& bounds)
+        {
+            auto const [center, half_extent] = bounds;
+            auto const unit_uvs              = usesUnitTexCoords(mesh);
+
+            std::vector<PackedVertex> vertices(mesh.positions.size(), PackedVertex {});
+            for (std::size_t i = 0; i < vertices.size(); i++)
+            {
+                auto& vertex = vertices[i];
+
+                auto const [x, y, z] = mesh.positions[i] - center;
+                vertex.position[0]   = toSnorm16(x / half_extent.x);
+                vertex.position[1]   = toSnorm16(y / half_extent.y);
+                vertex.position[2]   = toSnorm16(z / half_extent.z);
+
+                if (mesh.has_textures)
+                {
+                    auto const [u, v]   = mesh.tex_coords[i];
+                    vertex.tex_coord[0] = unit_uvs ? toUnorm16(u) : toHalf(u);
+                    vertex.tex_coord[1] = unit_uvs ? toUnorm16(v) : toHalf(v);
+                }
+
+                if (mesh.has_normals)
+                {
+                    auto const [nx, ny, nz] = mesh.normals[i];
+                    auto const scaled = Vector3 {nx * half_extent.x, ny * half_extent.y, nz * half_extent.z};
+                    auto const length = scaled.magnitude();
+                    vertex.normal     = toInt2101010(length > 0 ? scaled * (1 / length) : scaled);
+                }
+            }
+            return vertices;
+        }
+
+        Vector3 fromInt2101010(std::uint32_t const packed)
+        {
+            auto const component = [&](unsigned const shift)
+            {
+                auto const bits  = static_cast<int>((packed >> shift) & 0x3FFu);
+                auto const value = bits & 0x200 ? bits - 0x400 : bits;
+                return std::max(static_cast<float>(value) / 511.f, -1.f);
+            };
+            return {component(0), component(10), component(20)};
+        }
+
+        using Color8 = std::array<std::uint8_t, 4>; // unorm8 RGBA.
+
+        std::vector<Color8> packColors(std::vector<Vector4> const& colors)
+        {
+            auto const channel = [](float const value)
+            {
+                return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+            };
+
+            std::vector<Color8> packed;
+            packed.reserve(colors.size());
+            for (auto const [r, g, b, a] : colors)
+                packed.push_back({channel(r), channel(g), channel(b), channel(a)});
+            return packed;
+        }
+
+        Matrix4 dequantizationFor(IndexedMesh const& mesh, config::VertexFormat const format)
+        {
+            if (format == config::VertexFormat::Float) return Matrix4::identity();
+
+            auto const [center, half_extent] = boundsOf(mesh.positions);
+            return Matrix4::translation(center) * Matrix4::scaling(half_extent);
+        }
+
+        MeshDescription describe(IndexedMesh const& mesh, config::Geometry const& geometry)
+        {
+            if (mesh.lods.size() > MeshDescription::MaxLods)
+                throw std::invalid_argument("Mesh has more levels of detail than a description can hold.");
+
+            MeshDescription description {
+                geometry,
+                mesh.vertexCount(),
+                mesh.indexCount(),
+                indexTypeFor(mesh),
+                mesh.has_normals,
+                mesh.has_textures,
+                mesh.has_colors,
+                usesUnitTexCoords(mesh),
+                dequantizationFor(mesh, geometry.format),
+                Box::of(mesh.positions),
+                0,
+                {}
+            };
+
+            if (mesh.lods.empty()) description.lods[description.lod_count++] = {0, mesh.indexCount(), 0.f};
+            for (auto const& lod : mesh.lods) { description.lods[description.lod_count++] = lod; }
+            return description;
+        }
+
+        // Lays the mesh out as the geometry asks and hands the resulting buffers to `use`, which must not keep them.
+        template <class Use>
+        auto withBuffers(IndexedMesh const& mesh, config::Geometry const& geometry, Use use)
+        {
+            MeshBuffers buffers {describe(mesh, geometry), {}, bytesOf(mesh.indices)};
+
+            std::vector<GLushort> short_indices;
+            if (buffers.description.index_type == GL_UNSIGNED_SHORT)
             {
-                glGenBuffers(1, &vbo_vt);
-                glBindBuffer(GL_ARRAY_BUFFER, vbo_vt);
-                glBufferData(GL_ARRAY_BUFFER, vs.size() * sizeof(Vector3), vs.data(), GL_STATIC_DRAW);
-                glEnableVertexAttribArray(Pipeline::Position);
-                glVertexAttribPointer(Pipeline::Position, 3, GL_FLOAT, GL_FALSE, sizeof(Vector3), nullptr);
+                short_indices.assign(mesh.indices.begin(), mesh.indices.end());
+                buffers.indices = bytesOf(short_indices);
+            }
+
+            std::vector<PackedVertex> packed;
+            std::vector<Vertex>       interleaved;
+            if (geometry.format == config::VertexFormat::Packed)
+            {
+                packed = pack(mesh, boundsOf(mesh.positions));
+                buffers.vertex_streams.push_back(bytesOf(packed));
+            }
+            else if (geometry.layout == config::VertexLayout::Interleaved)
+            {
+                interleaved = interleave(mesh);
+                buffers.vertex_streams.push_back(bytesOf(interleaved));
+            }
+            else
+            {
+                buffers.vertex_streams.push_back(bytesOf(mesh.positions));
+                if (mesh.has_textures) buffers.vertex_streams.push_back(bytesOf(mesh.tex_coords));
+                if (mesh.has_normals) buffers.vertex_streams.push_back(bytesOf(mesh.normals));
+            }
+
+            std::vector<Color8> colors;
+            if (mesh.has_colors)
+            {
+                colors = packColors(mesh.colors);
+                buffers.vertex_streams.push_back(bytesOf(colors));
+            }
+            return use(std::as_const(buffers));
+        }
+
+        // Sizes of the vertex streams createVao expects, in the order it binds them.
+        std::vector<std::size_t> streamSizes(MeshDescription const& description)
+        {
+            auto const count = static_cast<std::size_t>(description.vertex_count);
+
+            std::vector<std::size_t> sizes;
+            if (description.geometry.format == config::VertexFormat::Packed)
+                sizes.push_back(count * sizeof(PackedVertex));
+            else if (description.geometry.layout == config::VertexLayout::Interleaved)
+                sizes.push_back(count * sizeof(Vertex));
+            else
+            {
+                sizes.push_back(count * sizeof(Vector3));
+                if (description.has_textures) sizes.push_back(count * sizeof(Vector2));
+                if (description.has_normals) sizes.push_back(count * sizeof(Vector3));
+            }
+            if (description.has_colors) sizes.push_back(count * sizeof(Color8));
+            return sizes;
+        }
+
+        // Reads element i of a stream of T, which may not be aligned for it.
+        template <class T>
+        T elementAt(ByteView const stream, std::size_t const i)
+        {
+            T element;
+            std::memcpy(&element, static_cast<Ptr<std::byte const>>(stream.data) + i * sizeof(T), sizeof(T));
+            return element;
+        }
+
+        // Undoes pack, with the positions back in model space and the normals no longer scaled by the bounds.
+        void unpack(MeshBuffers const& buffers, IndexedMesh& mesh)
+        {
+            auto const& description = buffers.description;
+            auto const& m           = description.dequantization;
+            auto const  scale       = Vector3 {m[0], m[5], m[10]};
+
+            for (std::size_t i = 0; i < mesh.positions.size(); i++)
+            {
+                auto const packed = elementAt<PackedVertex>(buffers.vertex_streams.front(), i);
+
+                auto const snorm = [&](std::size_t const axis)
+                {
+                    return std::max(packed.position[axis] / 32767.f, -1.f);
+                };
+                auto const x = snorm(0), y = snorm(1), z = snorm(2);
+                mesh.positions[i] = {
+                    m[0] * x + m[1] * y + m[2] * z + m[3],
+                    m[4] * x + m[5] * y + m[6] * z + m[7],
+                    m[8] * x + m[9] * y + m[10] * z + m[11]
+                };
 
                 if (mesh.has_textures)
                 {
-                    glGenBuffers(1, &vbo_tx);
-                    glBindBuffer(GL_ARRAY_BUFFER, vbo_tx);
-                    glBufferData(GL_ARRAY_BUFFER, ts.size() * sizeof(Vector2), ts.data(), GL_STATIC_DRAW);
-                    glEnableVertexAttribArray(Pipeline::Texture);
-                    glVertexAttribPointer(Pipeline::Texture, 2, GL_FLOAT, GL_FALSE, sizeof(Vector2), nullptr);
+                    auto const decode = [&](std::uint16_t const value)
+                    {
+                        return description.unit_tex_coords ? value / 65535.f : fromHalf(value);
+                    };
+                    mesh.tex_coords[i] = {decode(packed.tex_coord[0]), decode(packed.tex_coord[1])};
                 }
+
                 if (mesh.has_normals)
                 {
-                    glGenBuffers(1, &vbo_n);
-                    glBindBuffer(GL_ARRAY_BUFFER, vbo_n);
-                    glBufferData(GL_ARRAY_BUFFER, ns.size() * sizeof(Vector3), ns.data(), GL_STATIC_DRAW);
-                    glEnableVertexAttribArray(Pipeline::Normal);
-                    glVertexAttribPointer(Pipeline::Normal, 3, GL_FLOAT, GL_FALSE, sizeof(Vector3), nullptr);
+                    auto const [nx, ny, nz] = fromInt2101010(packed.normal);
+                    auto const normal       = Vector3 {nx / scale.x, ny / scale.y, nz / scale.z};
+                    auto const length       = normal.magnitude();
+                    mesh.normals[i]         = length > 0 ? normal * (1 / length) : normal;
+                }
+            }
+        }
+
+        // Whether cached buffers were built with this geometry and are consistent with their own description.
+        bool fits(MeshBuffers const& buffers, config::Geometry const& geometry)
+        {
+            auto const& description = buffers.description;
+            if (description.geometry.layout != geometry.layout || description.geometry.format != geometry.format)
+                return false;
+            if (description.geometry.optimization != geometry.optimization) return false;
+            if (description.geometry.lods != geometry.lods) return false;
+
+            if (description.vertex_count < 0 || description.index_count < 0) return false;
+            if (description.lod_count == 0 || description.lod_count > MeshDescription::MaxLods) return false;
+            for (std::uint32_t level = 0; level < description.lod_count; level++)
+            {
+                auto const [first_index, index_count, _] = description.lods[level];
+                if (first_index < 0 || index_count < 0 || index_count > description.index_count - first_index)
+                    return false;
+            }
+            if (description.index_type != GL_UNSIGNED_SHORT && description.index_type != GL_UNSIGNED_INT) return false;
+
+            auto const index_size = description.index_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+            if (buffers.indices.size != static_cast<std::size_t>(description.index_count) * index_size) return false;
+
+            auto const sizes = streamSizes(description);
+            return std::equal(
+                sizes.begin(),
+                sizes.end(),
+                buffers.vertex_streams.begin(),
+                buffers.vertex_streams.end(),
+                [](std::size_t const size, ByteView const stream) { return size == stream.size; }
+            );
+        }
+
+        // Uploads the buffers, appending their names to buffer_ids so they can be read back, and binds them to a VAO.
+        GLuint createVao(MeshBuffers const& buffers, std::vector<GLuint>& buffer_ids)
+        {
+            auto const& description = buffers.description;
+
+            GLuint vao_id;
+
+            auto       stream = buffers.vertex_streams.begin();
+            auto const upload = [&] { buffer_ids.push_back(uploadBuffer(GL_ARRAY_BUFFER, *stream++)); };
+
+            glGenVertexArrays(1, &vao_id);
+            GlState::current().bindVertexArray(vao_id);
+            {
+                if (description.geometry.format == config::VertexFormat::Packed)
+                {
+                    constexpr GLsizei Stride = sizeof(PackedVertex);
+
+                    auto const tex_type = description.unit_tex_coords ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT;
+                    auto const tex_norm = tex_type == GL_UNSIGNED_SHORT ? GL_TRUE : GL_FALSE;
+
+                    upload();
+                    bindAttribute(Pipeline::Position, 3, GL_SHORT, GL_TRUE, Stride, offsetof(PackedVertex, position));
+                    if (description.has_textures)
+                    {
+                        bindAttribute(
+                            Pipeline::Texture,
+                            2,
+                            tex_type,
+                            tex_norm,
+                            Stride,
+                            offsetof(PackedVertex, tex_coord)
+                        );
+                    }
+                    if (description.has_normals)
+                    {
+                        bindAttribute(
+                            Pipeline::Normal,
+                            4,
+                            GL_INT_2_10_10_10_REV,
+                            GL_TRUE,
+                            Stride,
+                            offsetof(PackedVertex, normal)
+                        );
+                    }
                 }
+                else if (description.geometry.layout == config::VertexLayout::Interleaved)
+                {
+                    constexpr GLsizei Stride = sizeof(Vertex);
+
+                    upload();
+                    bindAttribute(Pipeline::Position, 3, Stride, offsetof(Vertex, position));
+                    if (description.has_textures)
+                        bindAttribute(Pipeline::Texture, 2, Stride, offsetof(Vertex, tex_coord));
+                    if (description.has_normals)
+                        bindAttribute(Pipeline::Normal, 3, Stride, offsetof(Vertex, normal));
+                }
+                else
+                {
+                    upload();
+                    bindAttribute(Pipeline::Position, 3, sizeof(Vector3), 0);
+
+                    if (description.has_textures)
+                    {
+                        upload();
+                        bindAttribute(Pipeline::Texture, 2, sizeof(Vector2), 0);
+                    }
+                    if (description.has_normals)
+                    {
+                        upload();
+                        bindAttribute(Pipeline::Normal, 3, sizeof(Vector3), 0);
+                    }
+                }
+
+                if (description.has_colors)
+                {
+                    upload();
+                    bindAttribute(Pipeline::VertexColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Color8), 0);
+                }
+
+                // The element buffer binding is part of the VAO state, so it must stay bound until the VAO is unbound.
+                buffer_ids.push_back(uploadBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indices));
+                bindInstanceAttributes();
             }
-            glBindVertexArray(0);
+            GlState::current().bindVertexArray(0);
             glBindBuffer(GL_ARRAY_BUFFER, 0);
-            glDeleteBuffers(1, &vbo_vt);
-            glDeleteBuffers(1, &vbo_tx);
-            glDeleteBuffers(1, &vbo_n);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
             return vao_id;
         }
+
+        // Arena pools are told apart by whatever changes their attribute formats.
+        struct ArenaFormat
+        {
+            std::uint32_t id;
+            GLsizei       stride;
+        };
+
+        // The pool the mesh's vertices fit in, if they are all in a single stream.
+        std::optional<ArenaFormat> arenaFormatOf(MeshDescription const& description)
+        {
+            if (description.has_colors) return std::nullopt;
+            if (description.geometry.format == config::VertexFormat::Packed)
+                return ArenaFormat {description.unit_tex_coords ? 2u : 1u, sizeof(PackedVertex)};
+            if (description.geometry.layout == config::VertexLayout::Interleaved)
+                return ArenaFormat {0, sizeof(Vertex)};
+            return std::nullopt;
+        }
+
+        // Like createVao's, but with every attribute enabled, so meshes without texture coordinates or normals read
+        // the zeros they were laid out with instead of the attributes' current values, which are zero too.
+        void bindArenaAttributes(MeshDescription const& description)
+        {
+            auto const attribute = [](
+                GLuint const      index,
+                GLint const       size,
+                GLenum const      type,
+                GLboolean const   normalized,
+                std::size_t const offset
+            )
+            {
+                glEnableVertexAttribArray(index);
+                glVertexAttribFormat(index, size, type, normalized, static_cast<GLuint>(offset));
+                glVertexAttribBinding(index, 0);
+            };
+
+            if (description.geometry.format == config::VertexFormat::Packed)
+            {
+                auto const tex_type = description.unit_tex_coords ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT;
+                auto const tex_norm = tex_type == GL_UNSIGNED_SHORT ? GL_TRUE : GL_FALSE;
+
+                attribute(Pipeline::Position, 3, GL_SHORT, GL_TRUE, offsetof(PackedVertex, position));
+                attribute(Pipeline::Texture, 2, tex_type, tex_norm, offsetof(PackedVertex, tex_coord));
+                attribute(Pipeline::Normal, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedVertex, normal));
+            }
+            else
+            {
+                attribute(Pipeline::Position, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
+                attribute(Pipeline::Texture, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, tex_coord));
+                attribute(Pipeline::Normal, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normal));
+            }
+            bindInstanceAttributes();
+        }
+
+        std::optional<GeometryArena::Allocation> placeInArena(MeshBuffers const& buffers, config::MeshArena const arena)
+        {
+            if (arena == config::MeshArena::Off) return std::nullopt;
+
+            auto const format = arenaFormatOf(buffers.description);
+            if (!format) return std::nullopt;
+
+            auto const& description = buffers.description;
+            return GeometryArena::current().allocate(
+                format->id,
+                format->stride,
+                [&description] { bindArenaAttributes(description); },
+                buffers
+            );
+        }
+
+        std::vector<std::byte> readBuffer(GLuint const buffer_id, std::size_t const offset, std::size_t const size)
+        {
+            std::vector<std::byte> bytes(size);
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer_id);
+            if (size != 0)
+            {
+                glGetBufferSubData(
+                    GL_COPY_READ_BUFFER,
+                    static_cast<GLintptr>(offset),
+                    static_cast<GLsizeiptr>(size),
+                    bytes.data()
+                );
+            }
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            return bytes;
+        }
+
+        IndexedMesh prepareMesh(MeshLoader const& loaded, config::Geometry const& geometry)
+        {
+            auto mesh = IndexedMesh::fromLoader(loaded);
+            if (geometry.optimization == config::MeshOptimization::On)
+            {
+                [[maybe_unused]] auto const report = optimizeMesh(mesh);
+                #ifdef _DEBUG
+                std::cerr << "Mesh optimized: ACMR " << report.before.acmr << " -> " << report.after.acmr
+                    << ", ATVR " << report.before.atvr << " -> " << report.after.atvr << '.' << std::endl;
+                #endif
+            }
+            if (geometry.lods == config::MeshLods::On) buildLods(mesh, geometry.optimization);
+            return mesh;
+        }
+
+        // Like withBuffers, but reuses the loader's prebuilt buffers when they fit and caches freshly built ones.
+        template <class Use>
+        auto withLoaderBuffers(MeshLoader const& loaded, config::Geometry const& geometry, Use use)
+        {
+            if (auto const prebuilt = loaded.prebuilt(); prebuilt != nullptr)
+            {
+                if (fits(*prebuilt, geometry)) return use(*prebuilt);
+
+                // Built with another geometry and the loader parsed nothing, so the source is read again.
+                auto const mapped   = engine::MappedFile {loaded.source};
+                auto       reparsed = parseMeshSource(mapped.view());
+                reparsed.source       = loaded.source;
+                reparsed.source_stamp = MeshSourceStamp::of(loaded.source, mapped.view());
+                return withLoaderBuffers(reparsed, geometry, use);
+            }
+
+            return withBuffers(
+                prepareMesh(loaded, geometry),
+                geometry,
+                [&](MeshBuffers const& buffers)
+                {
+                    if (!loaded.source.empty()) MeshCache::store(loaded.source, loaded.source_stamp, buffers);
+                    return use(buffers);
+                }
+            );
+        }
+    }
+
+    void bakeMesh(MeshLoader const& loaded, config::Geometry const& geometry, MeshBufferSink const& use)
+    {
+        withLoaderBuffers(loaded, geometry, use);
     }
 
-    MeshLoader MeshLoader::fromFile(std::filesystem::path const& mesh_file)
+    MeshLoader MeshLoader::fromFile(
+        std::filesystem::path const&          mesh_file,
+        OptPtr<engine::AssetPack const> const assets,
+        OptPtr<engine::JobSystem> const       jobs
+    )
     {
+        if (assets != nullptr)
+        {
+            if (auto baked = assets->mesh(mesh_file))
+            {
+                MeshLoader loaded;
+                loaded.source = mesh_file;
+                loaded.baked  = std::move(baked);
+                return loaded;
+            }
+        }
+
         if (!exists(mesh_file))
             throw std::invalid_argument("File not found: " + mesh_file.string());
 
         try
         {
-            std::ifstream in;
-            in.exceptions(std::ios_base::badbit);
-            in.open(mesh_file);
-
-            return parseMeshFile(in);
+            MeshLoader loaded;
+            if (auto cache = MeshCache::open(mesh_file))
+            {
+                loaded.cache = std::move(cache);
+            }
+            else
+            {
+                auto const mapped   = engine::MappedFile {mesh_file};
+                loaded              = parseMeshSource(mapped.view(), jobs);
+                loaded.source_stamp = MeshSourceStamp::of(mesh_file, mapped.view());
+            }
+            loaded.source = mesh_file;
+            return loaded;
         }
         catch (...)
         {
@@ -117,56 +1004,171 @@ namespace render
         }
     }
 
+    MeshLoader MeshLoader::fromSource(std::string_view const source, OptPtr<engine::JobSystem> const jobs)
+    {
+        return parseMeshSource(source, jobs);
+    }
+
     GLsizei MeshLoader::size() const { return vert_ids.size(); }
 
-    void MeshLoader::parseVec(std::istream& in)
+    OptPtr<MeshBuffers const> MeshLoader::prebuilt() const
     {
-        Vector3 v;
-        in >> v;
-        vertices.push_back(v);
+        if (baked) return &*baked;
+        if (cache) return &cache->buffers();
+        return nullptr;
     }
 
-    void MeshLoader::parseTex(std::istream& in)
+    void MeshLoader::bake(config::Geometry const& geometry)
     {
-        Vector2 v;
-        in >> v;
-        tex_coords.push_back(v);
+        if (auto const buffers = prebuilt(); buffers != nullptr && fits(*buffers, geometry)) return;
+
+        withLoaderBuffers(
+            *this,
+            geometry,
+            [&](MeshBuffers const& built)
+            {
+                auto size = built.indices.size;
+                for (auto const stream : built.vertex_streams) { size += stream.size; }
+
+                std::vector<char> storage(size);
+                auto              cursor = storage.data();
+                auto const        copy   = [&](ByteView const bytes)
+                {
+                    if (bytes.size != 0) std::memcpy(cursor, bytes.data, bytes.size);
+                    cursor += bytes.size;
+                    return ByteView {cursor - bytes.size, bytes.size};
+                };
+
+                MeshBuffers copied {built.description, {}, {}};
+                for (auto const stream : built.vertex_streams) { copied.vertex_streams.push_back(copy(stream)); }
+                copied.indices = copy(built.indices);
+
+                baked         = std::move(copied);
+                baked_storage = std::move(storage);
+            }
+        );
+
+        vertices   = {};
+        tex_coords = {};
+        normals    = {};
+        vert_ids   = {};
+        tex_ids    = {};
+        norm_ids   = {};
+        cache.reset();
     }
 
-    void MeshLoader::parseNorm(std::istream& in)
+    IndexedMesh IndexedMesh::fromLoader(MeshLoader const& loader)
     {
-        Vector3 v;
-        in >> v;
-        normals.push_back(v);
+        auto const corner_count = loader.vert_ids.size();
+        if (loader.has_textures && loader.tex_ids.size() != corner_count)
+            throw std::invalid_argument("Mesh mixes faces with and without texture coordinates.");
+        if (loader.has_normals && loader.norm_ids.size() != corner_count)
+            throw std::invalid_argument("Mesh mixes faces with and without normals.");
+
+        IndexedMesh mesh;
+        mesh.has_textures = loader.has_textures;
+        mesh.has_normals  = loader.has_normals;
+        mesh.indices.reserve(corner_count);
+
+        CornerTable table {corner_count};
+        for (std::size_t i = 0; i < corner_count; i++)
+        {
+            auto const corner = Corner {
+                loader.vert_ids[i],
+                loader.has_textures ? loader.tex_ids[i] : 0,
+                loader.has_normals ? loader.norm_ids[i] : 0
+            };
+
+            auto const next = static_cast<GLuint>(mesh.positions.size());
+            if (auto const [index, inserted] = table.insert(corner, next); !inserted)
+            {
+                mesh.indices.push_back(index);
+                continue;
+            }
+
+            mesh.positions.push_back(fetch(loader.vertices, corner.vert));
+            if (loader.has_textures) mesh.tex_coords.push_back(fetch(loader.tex_coords, corner.tex));
+            if (loader.has_normals) mesh.normals.push_back(fetch(loader.normals, corner.norm));
+            mesh.indices.push_back(next);
+        }
+        return mesh;
     }
 
-    void MeshLoader::parseFace(std::istream& in)
+    GLsizei IndexedMesh::vertexCount() const { return static_cast<GLsizei>(positions.size()); }
+    GLsizei IndexedMesh::indexCount() const { return static_cast<GLsizei>(indices.size()); }
+
+    IndexedMesh IndexedMesh::fromBuffers(MeshBuffers const& buffers)
     {
-        if (normals.empty()) has_normals = true;
-        if (tex_coords.empty()) has_textures = true;
+        auto const& description = buffers.description;
+        auto const  count       = static_cast<std::size_t>(description.vertex_count);
 
-        if (std::string token; !has_normals && !has_textures)
+        IndexedMesh mesh;
+        mesh.has_normals  = description.has_normals;
+        mesh.has_textures = description.has_textures;
+        mesh.has_colors   = description.has_colors;
+        mesh.positions.resize(count);
+        if (mesh.has_textures) mesh.tex_coords.resize(count);
+        if (mesh.has_normals) mesh.normals.resize(count);
+        if (mesh.has_colors) mesh.colors.resize(count);
+        if (buffers.vertex_streams.empty()) return mesh;
+
+        auto stream = buffers.vertex_streams.begin();
+        if (description.geometry.format == config::VertexFormat::Packed)
+        {
+            unpack(buffers, mesh);
+            ++stream;
+        }
+        else if (description.geometry.layout == config::VertexLayout::Interleaved)
         {
-            for (int i = 0; i < 3; i++)
+            for (std::size_t i = 0; i < count; i++)
             {
-                in >> token;
-                vert_ids.push_back(std::stoi(token));
+                auto const vertex = elementAt<Vertex>(*stream, i);
+                mesh.positions[i] = vertex.position;
+                if (mesh.has_textures) mesh.tex_coords[i] = vertex.tex_coord;
+                if (mesh.has_normals) mesh.normals[i] = vertex.normal;
             }
+            ++stream;
         }
         else
         {
-            for (int i = 0; i < 3; i++)
-            {
-                std::getline(in, token, '/');
-                if (!token.empty()) vert_ids.push_back(std::stoi(token));
+            std::memcpy(mesh.positions.data(), (stream++)->data, count * sizeof(Vector3));
+            if (mesh.has_textures) std::memcpy(mesh.tex_coords.data(), (stream++)->data, count * sizeof(Vector2));
+            if (mesh.has_normals) std::memcpy(mesh.normals.data(), (stream++)->data, count * sizeof(Vector3));
+        }
 
-                std::getline(in, token, '/');
-                if (!token.empty()) tex_ids.push_back(std::stoi(token));
+        for (std::size_t i = 0; mesh.has_colors && i < count; i++)
+        {
+            auto const [r, g, b, a] = elementAt<Color8>(*stream, i);
+            auto const color        = Vector4 {
+                static_cast<float>(r), static_cast<float>(g), static_cast<float>(b), static_cast<float>(a)
+            };
+            mesh.colors[i] = color * (1 / 255.f);
+        }
 
-                std::getline(in, token, ' ');
-                if (!token.empty()) norm_ids.push_back(std::stoi(token));
-            }
+        // Only the full mesh, coarser levels of detail may bulge out of it.
+        auto const [first, index_count, _] = description.lods[0];
+        mesh.indices.resize(static_cast<std::size_t>(index_count));
+        for (std::size_t i = 0; i < mesh.indices.size(); i++)
+        {
+            auto const at = static_cast<std::size_t>(first) + i;
+            if (description.index_type == GL_UNSIGNED_SHORT) mesh.indices[i] = elementAt<GLushort>(buffers.indices, at);
+            else mesh.indices[i] = elementAt<GLuint>(buffers.indices, at);
         }
+        return mesh;
+    }
+
+    OccluderMesh OccluderMesh::fromBuffers(MeshBuffers const& buffers)
+    {
+        auto mesh = IndexedMesh::fromBuffers(buffers);
+        return {std::move(mesh.positions), std::move(mesh.indices)};
+    }
+
+    OccluderMesh OccluderMesh::fromLoader(MeshLoader const& loaded)
+    {
+        if (auto const prebuilt = loaded.prebuilt(); prebuilt != nullptr) return fromBuffers(*prebuilt);
+
+        auto indexed = IndexedMesh::fromLoader(loaded);
+        return {std::move(indexed.positions), std::move(indexed.indices)};
     }
 
     Mesh Mesh::fromFile(std::filesystem::path const& mesh_file)
@@ -174,34 +1176,136 @@ namespace render
         return MeshLoader::fromFile(mesh_file);
     }
 
-    Mesh::Mesh(MeshLoader const& loaded)
-        : vao_id_ {createVao(loaded)},
-          vertex_count_ {loaded.size()}
+    Mesh::Mesh(MeshLoader const& loaded, config::Geometry const& geometry)
+        : Mesh(
+            withLoaderBuffers(
+                loaded,
+                geometry,
+                [arena = geometry.arena](MeshBuffers const& buffers) { return Mesh {buffers, arena}; }
+            )
+        )
+    {}
+
+    Mesh::Mesh(IndexedMesh const& indexed, config::Geometry const& geometry)
+        : Mesh(
+            withBuffers(
+                indexed,
+                geometry,
+                [arena = geometry.arena](MeshBuffers const& buffers) { return Mesh {buffers, arena}; }
+            )
+        )
     {}
 
+    Mesh::Mesh(MeshBuffers const& buffers, config::MeshArena const arena)
+        : allocation_ {placeInArena(buffers, arena)},
+          vao_id_ {allocation_ ? GeometryArena::current().vaoOf(*allocation_) : createVao(buffers, buffer_ids_)},
+          description_ {buffers.description}
+    {
+        description_.geometry.arena = allocation_ ? config::MeshArena::On : config::MeshArena::Off;
+        if (allocation_) description_.index_type = GL_UNSIGNED_INT;
+    }
+
     Mesh::Mesh(Mesh&& other) noexcept
-        : vao_id_ {std::exchange(other.vao_id_, 0)},
-          vertex_count_ {other.vertex_count_}
+        : buffer_ids_ {std::move(other.buffer_ids_)},
+          allocation_ {std::exchange(other.allocation_, std::nullopt)},
+          vao_id_ {std::exchange(other.vao_id_, 0)},
+          description_ {other.description_}
     {}
 
     Mesh& Mesh::operator=(Mesh&& other) noexcept
     {
         if (this != &other)
         {
-            vao_id_       = std::exchange(other.vao_id_, 0);
-            vertex_count_ = other.vertex_count_;
+            // What this one held is released along with the other one.
+            std::swap(vao_id_, other.vao_id_);
+            std::swap(buffer_ids_, other.buffer_ids_);
+            std::swap(allocation_, other.allocation_);
+            description_ = other.description_;
         }
         return *this;
     }
 
     Mesh::~Mesh()
     {
+        if (allocation_)
+        {
+            // The pool's VAO is shared with the other meshes in it.
+            GeometryArena::current().release(*allocation_);
+            return;
+        }
+
         if (vao_id_ != 0)
         {
+            GlState::current().forgetVertexArray(vao_id_);
             glDeleteVertexArrays(1, &vao_id_);
         }
+        glDeleteBuffers(static_cast<GLsizei>(buffer_ids_.size()), buffer_ids_.data());
+        buffer_ids_.clear();
     }
 
     GLuint  Mesh::vaoId() const { return vao_id_; }
-    GLsizei Mesh::vertexCount() const { return vertex_count_; }
+    GLsizei Mesh::vertexCount() const { return description_.vertex_count; }
+    GLsizei Mesh::indexCount() const { return description_.lods[0].index_count; }
+    GLenum  Mesh::indexType() const { return description_.index_type; }
+
+    std::size_t    Mesh::lodCount() const { return description_.lod_count; }
+    MeshLod const& Mesh::lod(std::size_t const level) const { return description_.lods[level]; }
+
+    GLuint Mesh::firstIndex(std::size_t const level) const
+    {
+        auto const first_index = static_cast<GLuint>(description_.lods[level].first_index);
+        return allocation_ ? allocation_->first_index + first_index : first_index;
+    }
+
+    void const* Mesh::lodIndices(std::size_t const level) const
+    {
+        auto const index_size = description_.index_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        return reinterpret_cast<void const*>(std::size_t {firstIndex(level)} * index_size);
+    }
+
+    GLint Mesh::baseVertex() const { return allocation_ ? allocation_->base_vertex : 0; }
+    bool  Mesh::inArena() const { return allocation_.has_value(); }
+
+    Matrix4 const&          Mesh::dequantization() const { return description_.dequantization; }
+    Box const&              Mesh::bounds() const { return description_.bounds; }
+    config::Geometry const& Mesh::geometry() const { return description_.geometry; }
+
+    IndexedMesh Mesh::read() const
+    {
+        std::vector<std::vector<std::byte>> contents;
+        if (allocation_)
+        {
+            auto const& arena  = GeometryArena::current();
+            auto const  stride = static_cast<std::size_t>(arenaFormatOf(description_)->stride);
+            auto const [_, base_vertex, vertex_count, first_index, index_count] = *allocation_;
+
+            contents.push_back(
+                readBuffer(
+                    arena.vertexBufferOf(*allocation_),
+                    static_cast<std::size_t>(base_vertex) * stride,
+                    static_cast<std::size_t>(vertex_count) * stride
+                )
+            );
+            contents.push_back(
+                readBuffer(
+                    arena.indexBuffer(),
+                    std::size_t {first_index} * sizeof(GLuint),
+                    static_cast<std::size_t>(index_count) * sizeof(GLuint)
+                )
+            );
+        }
+        for (auto const buffer_id : buffer_ids_)
+        {
+            GLint64 size = 0;
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer_id);
+            glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+            contents.push_back(readBuffer(buffer_id, 0, static_cast<std::size_t>(size)));
+        }
+        if (contents.empty()) return IndexedMesh::fromBuffers({description_, {}, {}});
+
+        MeshBuffers buffers {description_, {}, {contents.back().data(), contents.back().size()}};
+        for (auto stream = contents.begin(); stream + 1 != contents.end(); ++stream)
+            buffers.vertex_streams.push_back({stream->data(), stream->size()});
+        return IndexedMesh::fromBuffers(buffers);
+    }
 }
@@ -1,12 +1,26 @@
 ﻿#pragma once
 
 #include <filesystem>
+#include <functional>
+#include <optional>
+#include <string_view>
 #include <vector>
 
 #include <GL/glew.h>
 
+#include "GeometryArena.h"
+#include "MeshCache.h"
+#include "SlotMap.h"
+#include "../Config.h"
+#include "../Math/Matrix.h"
 #include "../Math/Vector.h"
 
+namespace engine
+{
+    class AssetPack;
+    class JobSystem;
+}
+
 namespace render
 {
     struct MeshLoader
@@ -19,25 +33,99 @@ namespace render
         std::vector<GLsizei> tex_ids;
         std::vector<GLsizei> norm_ids;
 
-        bool has_normals, has_textures;
+        bool has_normals  = false;
+        bool has_textures = false;
+
+        // Set by fromFile. When the file is in the asset pack or its cache is current, the built buffers are mapped
+        // instead of parsing the file, and the fields above stay empty.
+        std::filesystem::path      source;
+        MeshSourceStamp            source_stamp {};
+        std::optional<MeshCache>   cache;
+        std::optional<MeshBuffers> baked;
+        std::vector<char>          baked_storage; // Owns the baked buffers when they are not mapped from a pack.
 
-        static MeshLoader fromFile(std::filesystem::path const& mesh_file);
+        // Large sources are parsed in parallel on the jobs, when given.
+        static MeshLoader fromFile(
+            std::filesystem::path const&    mesh_file,
+            OptPtr<engine::AssetPack const> assets = {},
+            OptPtr<engine::JobSystem>       jobs   = {}
+        );
+        static MeshLoader fromSource(std::string_view source, OptPtr<engine::JobSystem> jobs = {});
 
         GLsizei size() const;
 
-        void parseVec(std::istream& in);
-        void parseTex(std::istream& in);
-        void parseNorm(std::istream& in);
-        void parseFace(std::istream& in);
+        [[nodiscard]] OptPtr<MeshBuffers const> prebuilt() const;
+
+        // Replaces the parsed data with the buffers a Mesh with this geometry uploads, so all that is left for the GL
+        // thread is the upload itself.
+        void bake(config::Geometry const& geometry);
+    };
+
+    using MeshBufferSink = std::function<void(MeshBuffers const&)>;
+
+    // Builds the buffers a Mesh would upload without touching GL, for tools such as the asset pack builder.
+    void bakeMesh(MeshLoader const& loaded, config::Geometry const& geometry, MeshBufferSink const& use);
+
+    // Mesh data with every distinct (position, texture coordinate, normal) combination stored once, and the
+    // triangles referring to them by index.
+    struct IndexedMesh
+    {
+        std::vector<Vector3> positions;
+        std::vector<Vector2> tex_coords;
+        std::vector<Vector3> normals;
+        std::vector<Vector4> colors; // Multiply the material's color, only merged meshes have them.
+        std::vector<GLuint>  indices;
+        std::vector<MeshLod> lods; // Ranges of the indices, from the full mesh on. Empty when they only hold that.
+
+        bool has_normals  = false;
+        bool has_textures = false;
+        bool has_colors   = false;
+
+        static IndexedMesh fromLoader(MeshLoader const& loader);
+        // Decodes the buffers back into model space, keeping only the full mesh's indices.
+        static IndexedMesh fromBuffers(MeshBuffers const& buffers);
+
+        GLsizei vertexCount() const;
+        GLsizei indexCount() const;
+    };
+
+    // Attributes of one object drawn by an instanced pipeline, read from the buffer bound at a mesh's instance binding.
+    struct Instance
+    {
+        Matrix4 model; // Column major, unlike every other matrix here, since GL reads it a column per location.
+        Vector4 color;
+        Vector3 ambient_color;
+        Vector3 specular_color;
+        float   shininess;
     };
 
+    // Positions and triangles of a mesh kept in memory, for rasterizing it into the occlusion buffer on the CPU. It is
+    // usually a simplified stand-in for what an object draws, and must never cover more than that does.
+    struct OccluderMesh
+    {
+        std::vector<Vector3> positions; // In model space, so the dequantization is already applied.
+        std::vector<GLuint>  indices;
+
+        static OccluderMesh fromBuffers(MeshBuffers const& buffers);
+        static OccluderMesh fromLoader(MeshLoader const& loaded);
+    };
+
+    // Mesh uploaded to buffers of its own, or to the geometry arena when asked to and its vertex format fits there.
+    // Arena meshes draw from their pool's VAO, with their indices widened to 32 bit.
     class Mesh
     {
-        GLuint  vao_id_;
-        GLsizei vertex_count_;
+        std::vector<GLuint>                      buffer_ids_; // Streams in order, then the indices. Empty in the arena.
+        std::optional<GeometryArena::Allocation> allocation_;
+        GLuint                                   vao_id_;     // Initialized after the above, which it fills in.
+        MeshDescription                          description_;
 
     public:
-        Mesh(MeshLoader const& loaded);
+        // Vertex buffer binding of every mesh's VAO that the instance attributes are read from.
+        constexpr static GLuint InstanceBinding = 3;
+
+        Mesh(MeshLoader const& loaded, config::Geometry const& geometry = {});
+        Mesh(IndexedMesh const& indexed, config::Geometry const& geometry = {});
+        explicit Mesh(MeshBuffers const& buffers, config::MeshArena arena = config::MeshArena::Off);
         static Mesh fromFile(std::filesystem::path const& mesh_file);
 
         Mesh(Mesh const& other)            = delete;
@@ -50,5 +138,31 @@ namespace render
 
         [[nodiscard]] GLuint  vaoId() const;
         [[nodiscard]] GLsizei vertexCount() const;
+        [[nodiscard]] GLsizei indexCount() const; // Of the full mesh.
+        [[nodiscard]] GLenum  indexType() const;
+
+        // Levels of detail from the full mesh on, each drawn from its own range of the index buffer.
+        [[nodiscard]] std::size_t    lodCount() const;
+        [[nodiscard]] MeshLod const& lod(std::size_t level) const;
+        // Where the level's indices start in the bound index buffer, in indices and as the offset glDrawElements takes
+        // in place of a pointer.
+        [[nodiscard]] GLuint      firstIndex(std::size_t level) const;
+        [[nodiscard]] void const* lodIndices(std::size_t level) const;
+        // Added to every index when drawn, 0 unless the mesh is in the arena.
+        [[nodiscard]] GLint baseVertex() const;
+        [[nodiscard]] bool  inArena() const;
+
+        // Maps the stored positions back to model space, the identity unless the mesh uses the packed format.
+        [[nodiscard]] Matrix4 const& dequantization() const;
+        // Of the mesh in model space, so the dequantization is already applied.
+        [[nodiscard]] Box const& bounds() const;
+        [[nodiscard]] config::Geometry const& geometry() const;
+
+        // Reads the buffers back from the GPU, for merging meshes on the CPU. It waits for the GPU to catch up, so it
+        // is meant for edits rather than for every frame.
+        [[nodiscard]] IndexedMesh read() const;
     };
+
+    using MeshHandle     = Handle<Mesh>;
+    using OccluderHandle = Handle<OccluderMesh>;
 }
@@ -0,0 +1,206 @@
+﻿#include "MeshCache.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+namespace render
+{
+    namespace
+    {
+        using namespace std::filesystem;
+
+        constexpr char        Magic[8]   = {'C', 'G', 'J', 'M', 'E', 'S', 'H', '\0'};
+        constexpr std::size_t MaxStreams = 3;
+        constexpr std::size_t Alignment  = 16;
+
+        struct Range
+        {
+            std::uint64_t offset, size;
+        };
+
+        // Written as is, so the cache is only meant to be read back by the same build on the same machine.
+        struct Header
+        {
+            char            magic[8];
+            std::uint32_t   version;
+            std::uint32_t   stream_count;
+            MeshSourceStamp source;
+            MeshDescription description;
+            Range           streams[MaxStreams];
+            Range           indices;
+        };
+
+        static_assert(std::is_trivially_copyable_v<Header>);
+
+        std::uint64_t alignUp(std::uint64_t const offset) { return (offset + Alignment - 1) / Alignment * Alignment; }
+
+        // FNV-1a over 8 byte words, the source files are far too large to hash a byte at a time.
+        std::uint64_t hashOf(std::string_view const bytes)
+        {
+            constexpr std::uint64_t Prime = 0x100000001B3;
+
+            std::uint64_t hash = 0xCBF29CE484222325;
+            std::size_t   i    = 0;
+            for (; i + sizeof(std::uint64_t) <= bytes.size(); i += sizeof(std::uint64_t))
+            {
+                std::uint64_t word;
+                std::memcpy(&word, bytes.data() + i, sizeof(word));
+                hash = (hash ^ word) * Prime;
+            }
+            for (; i < bytes.size(); i++) { hash = (hash ^ static_cast<unsigned char>(bytes[i])) * Prime; }
+            return hash;
+        }
+
+        std::int64_t timeOf(path const& source)
+        {
+            return static_cast<std::int64_t>(last_write_time(source).time_since_epoch().count());
+        }
+
+        // Whether the stamp still describes the source. A source that was only touched is hashed once, after which
+        // its new time is written into the cache, so later loads go by the time again.
+        bool isCurrent(path const& source, path const& cache_file, MeshSourceStamp const& stamp)
+        {
+            std::error_code error;
+            if (file_size(source, error) != stamp.size || error) return false;
+
+            auto const time = timeOf(source);
+            if (time == stamp.time) return true;
+
+            auto const contents = engine::MappedFile {source};
+            if (hashOf(contents.view()) != stamp.hash) return false;
+
+            // A cache that cannot be written to only costs hashing the source again next time.
+            std::fstream file {cache_file, std::ios::binary | std::ios::in | std::ios::out};
+            file.seekp(offsetof(Header, source) + offsetof(MeshSourceStamp, time));
+            file.write(reinterpret_cast<Ptr<char const>>(&time), sizeof(time));
+            return true;
+        }
+
+        // Every store writes a file of its own, so stores of the same source at once never write into each other's.
+        std::atomic<std::uint64_t> temporaries {0};
+    }
+
+    MeshSourceStamp MeshSourceStamp::of(path const& source, std::string_view const contents)
+    {
+        return {contents.size(), timeOf(source), hashOf(contents)};
+    }
+
+    MeshCache::MeshCache(engine::MappedFile&& file, MeshBuffers const& buffers)
+        : file_ {std::move(file)},
+          buffers_ {buffers}
+    {}
+
+    path MeshCache::fileFor(path const& source)
+    {
+        auto cache_file = source;
+        cache_file += ".meshcache";
+        return cache_file;
+    }
+
+    std::optional<MeshCache> MeshCache::open(path const& source)
+    {
+        auto const cache_file = fileFor(source);
+
+        std::error_code error;
+        if (!is_regular_file(cache_file, error)) return std::nullopt;
+
+        try
+        {
+            // Checked before mapping the cache, since a stamp that is refreshed is written into it.
+            Header header;
+            {
+                std::ifstream in {cache_file, std::ios::binary};
+                if (!in.read(reinterpret_cast<Ptr<char>>(&header), sizeof(header))) return std::nullopt;
+            }
+            if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version) return std::nullopt;
+            if (header.stream_count > MaxStreams || !isCurrent(source, cache_file, header.source)) return std::nullopt;
+
+            auto file = engine::MappedFile {cache_file};
+            if (file.size() < sizeof(Header)) return std::nullopt;
+            std::memcpy(&header, file.data(), sizeof(header));
+
+            auto const inFile = [&](Range const range)
+            {
+                return range.offset <= file.size() && range.size <= file.size() - range.offset;
+            };
+            auto const view = [&](Range const range) { return ByteView {file.data() + range.offset, range.size}; };
+
+            MeshBuffers buffers {header.description, {}, view(header.indices)};
+            if (!inFile(header.indices)) return std::nullopt;
+            for (std::uint32_t i = 0; i < header.stream_count; i++)
+            {
+                if (!inFile(header.streams[i])) return std::nullopt;
+                buffers.vertex_streams.push_back(view(header.streams[i]));
+            }
+            return MeshCache {std::move(file), buffers};
+        }
+        catch (std::exception const&)
+        {
+            return std::nullopt;
+        }
+    }
+
+    void MeshCache::store(path const& source, MeshSourceStamp const& stamp, MeshBuffers const& buffers)
+    {
+        if (buffers.vertex_streams.size() > MaxStreams)
+            throw std::invalid_argument("Mesh has more vertex streams than its cache can hold.");
+
+        Header header {};
+        std::memcpy(header.magic, Magic, sizeof(Magic));
+        header.version      = Version;
+        header.stream_count = static_cast<std::uint32_t>(buffers.vertex_streams.size());
+        header.source       = stamp;
+        header.description  = buffers.description;
+
+        auto offset = alignUp(sizeof(Header));
+        for (std::size_t i = 0; i < buffers.vertex_streams.size(); i++)
+        {
+            header.streams[i] = {offset, buffers.vertex_streams[i].size};
+            offset            = alignUp(offset + buffers.vertex_streams[i].size);
+        }
+        header.indices = {offset, buffers.indices.size};
+
+        // Written beside the cache and renamed over it, so a crash never leaves a truncated cache behind.
+        std::error_code error;
+        auto const      cache_file = fileFor(source);
+        auto            temporary  = cache_file;
+        temporary += '.' + std::to_string(temporaries++) + ".tmp";
+        {
+            std::ofstream out {temporary, std::ios::binary | std::ios::trunc};
+
+            std::uint64_t written = 0;
+            auto const    write   = [&](Ptr<void const> const data, std::uint64_t const size, std::uint64_t const at)
+            {
+                for (; written < at; written++) out.put('\0');
+                out.write(static_cast<Ptr<char const>>(data), static_cast<std::streamsize>(size));
+                written += size;
+            };
+
+            write(&header, sizeof(header), 0);
+            for (std::size_t i = 0; i < buffers.vertex_streams.size(); i++)
+                write(buffers.vertex_streams[i].data, header.streams[i].size, header.streams[i].offset);
+            write(buffers.indices.data, header.indices.size, header.indices.offset);
+
+            if (!out.flush())
+            {
+                std::cerr << "Cannot write mesh cache at " << cache_file << '.' << std::endl;
+                out.close();
+                remove(temporary, error);
+                return;
+            }
+        }
+
+        rename(temporary, cache_file, error);
+        if (error)
+        {
+            std::cerr << "Cannot write mesh cache at " << cache_file << ": " << error.message() << std::endl;
+            remove(temporary, error);
+        }
+    }
+
+    MeshBuffers const& MeshCache::buffers() const { return buffers_; }
+}
@@ -0,0 +1,97 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Bounds.h"
+#include "../Config.h"
+#include "../Math/Matrix.h"
+#include "../Engine/MappedFile.h"
+
+namespace render
+{
+    // Range of a mesh's indices drawing it at one level of detail, and how far that level strays from the full mesh,
+    // relative to the radius of the mesh's bounds.
+    struct MeshLod
+    {
+        GLsizei first_index;
+        GLsizei index_count;
+        float   error;
+    };
+
+    // Everything needed to recreate a mesh's VAO besides the contents of its buffers.
+    struct MeshDescription
+    {
+        static constexpr std::uint32_t MaxLods = 4;
+
+        config::Geometry geometry;
+
+        GLsizei vertex_count;
+        GLsizei index_count;
+        GLenum  index_type;
+
+        bool has_normals;
+        bool has_textures;
+        bool has_colors;      // In a stream of their own after the others, whatever the layout.
+        bool unit_tex_coords; // Packed texture coordinates are unorm16 when set, half floats otherwise.
+
+        Matrix4 dequantization;
+        Box     bounds; // Of the positions in model space, before quantization.
+
+        std::uint32_t lod_count;
+        MeshLod       lods[MaxLods]; // The full mesh first, then ever coarser ones, all within the index count.
+    };
+
+    struct ByteView
+    {
+        Ptr<void const> data;
+        std::size_t     size;
+    };
+
+    // The final GPU buffers of a mesh, viewed either from freshly built vectors or from a mapped cache file.
+    struct MeshBuffers
+    {
+        MeshDescription       description;
+        std::vector<ByteView> vertex_streams; // One per vertex buffer, in attribute order.
+        ByteView              indices;
+    };
+
+    // Identifies the contents of a mesh's source file. The hash is only compared when the size matches but the
+    // modification time does not, e.g. after a checkout touched the file.
+    struct MeshSourceStamp
+    {
+        std::uint64_t size;
+        std::int64_t  time;
+        std::uint64_t hash;
+
+        static MeshSourceStamp of(std::filesystem::path const& source, std::string_view contents);
+    };
+
+    // Binary sidecar next to a mesh file, holding its built buffers so later loads can upload them straight from the
+    // mapping instead of parsing, deduplicating and optimizing the source again.
+    class MeshCache
+    {
+        engine::MappedFile file_;
+        MeshBuffers        buffers_;
+
+        MeshCache(engine::MappedFile&& file, MeshBuffers const& buffers);
+
+    public:
+        static constexpr std::uint32_t Version = 6;
+
+        static std::filesystem::path fileFor(std::filesystem::path const& source);
+
+        // The cache of the source, or nothing when there is none or it is stale, corrupt or from another version.
+        static std::optional<MeshCache> open(std::filesystem::path const& source);
+
+        // Replaces the cache of the source. Failures are only logged, the cache merely speeds up later loads.
+        static void store(std::filesystem::path const& source, MeshSourceStamp const& stamp, MeshBuffers const& buffers);
+
+        [[nodiscard]] MeshBuffers const& buffers() const;
+    };
+}
@@ -0,0 +1,271 @@
+﻿#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+namespace render
+{
+    namespace
+    {
+        // Triangles using each vertex, in compressed rows: the triangles of vertex v are
+        // triangles[offsets[v]] .. triangles[offsets[v + 1] - 1].
+        struct Adjacency
+        {
+            std::vector<GLuint> offsets;
+            std::vector<GLuint> triangles;
+
+            explicit Adjacency(IndexedMesh const& mesh)
+                : offsets(mesh.positions.size() + 1, 0),
+                  triangles(mesh.indices.size())
+            {
+                for (auto const index : mesh.indices) { offsets[index + 1]++; }
+                std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+                auto cursor = std::vector<GLuint>(offsets.begin(), offsets.end() - 1);
+                for (std::size_t i = 0; i < mesh.indices.size(); i++)
+                    triangles[cursor[mesh.indices[i]]++] = static_cast<GLuint>(i / 3);
+            }
+
+            [[nodiscard]] GLuint liveCount(GLuint const vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+        };
+
+        // State of the Tipsify sweep, following Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex
+        // Locality and Reduced Overdraw" (2007).
+        class Tipsify
+        {
+            IndexedMesh const& mesh_;
+            unsigned           cache_size_;
+            Adjacency          adjacency_;
+
+            std::vector<GLuint>   live_;       // Triangles not yet emitted per vertex.
+            std::vector<unsigned> stamps_;     // Time each vertex last entered the simulated cache.
+            std::vector<bool>     emitted_;    // Per triangle.
+            std::vector<GLuint>   dead_ends_;  // Recently used vertices to resume from when fanning gets stuck.
+            std::vector<GLuint>   candidates_; // Vertices of the triangles emitted around the current fan.
+            unsigned              time_;
+            GLuint                cursor_;     // Next vertex to scan when the dead-end stack runs dry.
+
+        public:
+            Tipsify(IndexedMesh const& mesh, unsigned const cache_size)
+                : mesh_ {mesh},
+                  cache_size_ {cache_size},
+                  adjacency_ {mesh},
+                  live_(mesh.positions.size()),
+                  stamps_(mesh.positions.size(), 0),
+                  emitted_(mesh.indices.size() / 3, false),
+                  time_ {cache_size + 1},
+                  cursor_ {0}
+            {
+                for (GLuint v = 0; v < live_.size(); v++) { live_[v] = adjacency_.liveCount(v); }
+            }
+
+            std::vector<std::size_t> run(std::vector<GLuint>& out_indices)
+            {
+                std::vector<std::size_t> clusters;
+                if (live_.empty()) return clusters;
+
+                out_indices.clear();
+                out_indices.reserve(mesh_.indices.size());
+
+                auto fanning = static_cast<long long>(0);
+                auto jumped  = true;
+                while (fanning >= 0)
+                {
+                    auto const emitted = out_indices.size() / 3;
+                    if (jumped && (clusters.empty() || clusters.back() != emitted)) clusters.push_back(emitted);
+
+                    candidates_.clear();
+                    emitFan(static_cast<GLuint>(fanning), out_indices);
+
+                    std::tie(fanning, jumped) = nextVertex();
+                }
+                return clusters;
+            }
+
+        private:
+            void emitFan(GLuint const fanning, std::vector<GLuint>& out_indices)
+            {
+                auto const begin = adjacency_.offsets[fanning];
+                auto const end   = adjacency_.offsets[fanning + 1];
+                for (auto t = begin; t < end; t++)
+                {
+                    auto const triangle = adjacency_.triangles[t];
+                    if (emitted_[triangle]) continue;
+
+                    for (auto corner = 0; corner < 3; corner++)
+                    {
+                        auto const v = mesh_.indices[triangle * 3 + corner];
+                        out_indices.push_back(v);
+                        dead_ends_.push_back(v);
+                        candidates_.push_back(v);
+                        live_[v]--;
+
+                        if (time_ - stamps_[v] > cache_size_) { stamps_[v] = time_++; }
+                    }
+                    emitted_[triangle] = true;
+                }
+            }
+
+            // Picks the candidate that will still be in cache after its remaining triangles are emitted and that has
+            // been there the longest, or resumes from a dead end when no candidate qualifies.
+            std::pair<long long, bool> nextVertex()
+            {
+                long long best          = -1;
+                unsigned  best_priority = 0;
+                for (auto const v : candidates_)
+                {
+                    if (live_[v] == 0) continue;
+
+                    unsigned priority = 0;
+                    if (time_ - stamps_[v] + 2 * live_[v] <= cache_size_) { priority = time_ - stamps_[v]; }
+                    if (priority > best_priority)
+                    {
+                        best          = v;
+                        best_priority = priority;
+                    }
+                }
+                if (best != -1) return {best, false};
+                return {skipDeadEnd(), true};
+            }
+
+            long long skipDeadEnd()
+            {
+                while (!dead_ends_.empty())
+                {
+                    auto const v = dead_ends_.back();
+                    dead_ends_.pop_back();
+                    if (live_[v] > 0) return v;
+                }
+                for (; cursor_ < live_.size(); cursor_++)
+                    if (live_[cursor_] > 0) return cursor_;
+                return -1;
+            }
+        };
+
+        Vector3 faceNormal(Vector3 const a, Vector3 const b, Vector3 const c) { return (b - a) % (c - a); }
+    }
+
+    VertexCacheStats analyzeVertexCache(IndexedMesh const& mesh, unsigned const cache_size)
+    {
+        if (mesh.indices.empty() || mesh.positions.empty()) return {0, 0};
+
+        // A vertex is in the FIFO cache iff it was inserted fewer than `cache_size` misses ago.
+        std::vector<unsigned> stamps(mesh.positions.size(), 0);
+        unsigned              misses = 0;
+        for (auto const index : mesh.indices)
+        {
+            if (stamps[index] == 0 || misses - stamps[index] >= cache_size)
+            {
+                stamps[index] = ++misses;
+            }
+        }
+
+        auto const triangles = static_cast<float>(mesh.indices.size() / 3);
+        auto const vertices  = static_cast<float>(mesh.positions.size());
+        return {misses / triangles, misses / vertices};
+    }
+
+    std::vector<std::size_t> optimizeVertexCache(IndexedMesh& mesh, unsigned const cache_size)
+    {
+        std::vector<GLuint> reordered;
+        auto                clusters = Tipsify {mesh, cache_size}.run(reordered);
+        mesh.indices                 = std::move(reordered);
+        return clusters;
+    }
+
+    void optimizeOverdraw(IndexedMesh& mesh, std::vector<std::size_t> const& clusters)
+    {
+        auto const triangle_count = mesh.indices.size() / 3;
+        if (clusters.size() < 2) return;
+
+        auto const corner = [&](std::size_t const triangle, int const i)
+        {
+            return mesh.positions[mesh.indices[triangle * 3 + i]];
+        };
+
+        auto center = Vector3::filled(0);
+        for (std::size_t t = 0; t < triangle_count; t++)
+            center = center + (corner(t, 0) + corner(t, 1) + corner(t, 2)) * (1.f / 3);
+        center = center * (1.f / static_cast<float>(triangle_count));
+
+        struct Cluster
+        {
+            std::size_t begin, end;
+            float       potential;
+        };
+
+        std::vector<Cluster> sorted;
+        sorted.reserve(clusters.size());
+        for (std::size_t i = 0; i < clusters.size(); i++)
+        {
+            auto const begin = clusters[i];
+            auto const end   = i + 1 < clusters.size() ? clusters[i + 1] : triangle_count;
+
+            // Area weighted, since the unnormalized face normal's length is twice the triangle's area.
+            auto normal   = Vector3::filled(0);
+            auto centroid = Vector3::filled(0);
+            for (auto t = begin; t < end; t++)
+            {
+                auto const a = corner(t, 0), b = corner(t, 1), c = corner(t, 2);
+                normal   = normal + faceNormal(a, b, c);
+                centroid = centroid + (a + b + c) * (1.f / 3);
+            }
+            centroid = centroid * (1.f / static_cast<float>(end - begin));
+
+            auto const length = normal.magnitude();
+            sorted.push_back({begin, end, length > 0 ? (centroid - center) * normal * (1 / length) : 0});
+        }
+
+        std::stable_sort(
+            sorted.begin(),
+            sorted.end(),
+            [](Cluster const& lhs, Cluster const& rhs) { return lhs.potential > rhs.potential; }
+        );
+
+        std::vector<GLuint> reordered;
+        reordered.reserve(mesh.indices.size());
+        for (auto const& [begin, end, _] : sorted)
+            reordered.insert(reordered.end(), mesh.indices.begin() + begin * 3, mesh.indices.begin() + end * 3);
+        mesh.indices = std::move(reordered);
+    }
+
+    void optimizeVertexFetch(IndexedMesh& mesh)
+    {
+        constexpr auto Unassigned = ~GLuint {0};
+
+        std::vector<GLuint> remap(mesh.positions.size(), Unassigned);
+        GLuint              next = 0;
+        for (auto& index : mesh.indices)
+        {
+            if (remap[index] == Unassigned) remap[index] = next++;
+            index = remap[index];
+        }
+        // Vertices no triangle uses are kept, after all of the used ones.
+        for (auto& target : remap)
+            if (target == Unassigned) target = next++;
+
+        auto const permute = [&](auto& elements)
+        {
+            auto permuted = elements;
+            for (std::size_t i = 0; i < elements.size(); i++) { permuted[remap[i]] = elements[i]; }
+            elements = std::move(permuted);
+        };
+
+        permute(mesh.positions);
+        if (mesh.has_textures) permute(mesh.tex_coords);
+        if (mesh.has_normals) permute(mesh.normals);
+        if (mesh.has_colors) permute(mesh.colors);
+    }
+
+    MeshOptimizationReport optimizeMesh(IndexedMesh& mesh)
+    {
+        auto const before = analyzeVertexCache(mesh);
+
+        auto const clusters = optimizeVertexCache(mesh);
+        optimizeOverdraw(mesh, clusters);
+        optimizeVertexFetch(mesh);
+
+        return {before, analyzeVertexCache(mesh)};
+    }
+}
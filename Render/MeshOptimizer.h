@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#include <vector>
+
+#include "Mesh.h"
+
+namespace render
+{
+    // Size of the FIFO post-transform cache the optimizer targets and the statistics simulate.
+    constexpr unsigned DefaultCacheSize = 16;
+
+    struct VertexCacheStats
+    {
+        float acmr; // Average cache miss ratio: transformed vertices per triangle, 0.5 at best and 3 at worst.
+        float atvr; // Average transform to vertex ratio: transformed vertices per vertex, 1 at best.
+    };
+
+    struct MeshOptimizationReport
+    {
+        VertexCacheStats before, after;
+    };
+
+    [[nodiscard]] VertexCacheStats analyzeVertexCache(IndexedMesh const& mesh, unsigned cache_size = DefaultCacheSize);
+
+    // Reorders the triangles for post-transform cache locality (Tipsify), returning the first triangle of every
+    // cluster, i.e. of every run that was started after the fanning reached a dead end.
+    std::vector<std::size_t> optimizeVertexCache(IndexedMesh& mesh, unsigned cache_size = DefaultCacheSize);
+
+    // Reorders whole clusters so the ones facing away from the mesh's center, which are the likeliest occluders from
+    // any viewpoint, are drawn first. Triangles inside a cluster keep their order, and so their cache locality.
+    void optimizeOverdraw(IndexedMesh& mesh, std::vector<std::size_t> const& clusters);
+
+    // Renumbers the vertices in order of first use, so vertex fetches walk the buffers linearly.
+    void optimizeVertexFetch(IndexedMesh& mesh);
+
+    // Runs all of the above, in order.
+    MeshOptimizationReport optimizeMesh(IndexedMesh& mesh);
+}
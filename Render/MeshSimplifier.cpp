@@ -0,0 +1,411 @@
+﻿#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+
+#include "MeshOptimizer.h"
+
+namespace render
+{
+    namespace
+    {
+        // Sum of the squared distances to a set of planes, weighted by the area of the triangles they came from, as
+        // the upper triangle of a symmetric 4x4 matrix.
+        struct Quadric
+        {
+            double xx, xy, xz, xw, yy, yz, yw, zz, zw, ww;
+            double weight;
+
+            static Quadric plane(Vector3 const normal, double const distance, double const weight)
+            {
+                auto const [a, b, c] = normal;
+                auto const d         = distance;
+                return {
+                    a * a * weight, a * b * weight, a * c * weight, a * d * weight,
+                    b * b * weight, b * c * weight, b * d * weight,
+                    c * c * weight, c * d * weight,
+                    d * d * weight,
+                    weight
+                };
+            }
+
+            Quadric& operator+=(Quadric const& other)
+            {
+                xx += other.xx, xy += other.xy, xz += other.xz, xw += other.xw;
+                yy += other.yy, yz += other.yz, yw += other.yw;
+                zz += other.zz, zw += other.zw;
+                ww += other.ww;
+                weight += other.weight;
+                return *this;
+            }
+
+            // Mean squared distance of the point to the planes.
+            [[nodiscard]] double error(Vector3 const point) const
+            {
+                if (weight <= 0) return 0;
+
+                auto const x = double {point.x}, y = double {point.y}, z = double {point.z};
+                auto const sum = xx * x * x + 2 * xy * x * y + 2 * xz * x * z + 2 * xw * x
+                                 + yy * y * y + 2 * yz * y * z + 2 * yw * y
+                                 + zz * z * z + 2 * zw * z
+                                 + ww;
+                return std::max(sum, 0.0) / weight;
+            }
+        };
+
+        Quadric operator+(Quadric left, Quadric const& right) { return left += right; }
+
+        Vector3 cross(Vector3 const a, Vector3 const b)
+        {
+            return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+        }
+
+        float dot(Vector3 const a, Vector3 const b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+        Vector3 normalOf(Vector3 const a, Vector3 const b, Vector3 const c) { return cross(b - a, c - a); }
+
+        // Vertices sharing a position, which are simplified as one. Each group is named after its first vertex in
+        // order of position, and its vertices are listed next to each other.
+        struct PositionGroups
+        {
+            std::vector<GLuint> group_of;    // Of each vertex.
+            std::vector<GLuint> by_position; // Every vertex, grouped.
+            std::vector<GLuint> first;       // Where each group's vertices start, indexed by its name.
+            std::vector<GLuint> count;
+
+            explicit PositionGroups(IndexedMesh const& mesh)
+                : group_of(mesh.positions.size()),
+                  by_position(mesh.positions.size()),
+                  first(mesh.positions.size(), 0),
+                  count(mesh.positions.size(), 0)
+            {
+                auto const position = [&](GLuint const vertex)
+                {
+                    auto const [x, y, z] = mesh.positions[vertex];
+                    return std::tuple {x, y, z};
+                };
+                std::iota(by_position.begin(), by_position.end(), 0);
+                std::sort(
+                    by_position.begin(),
+                    by_position.end(),
+                    [&](GLuint const lhs, GLuint const rhs) { return position(lhs) < position(rhs); }
+                );
+                for (std::size_t begin = 0, end; begin < by_position.size(); begin = end)
+                {
+                    auto const group = by_position[begin];
+                    for (end = begin; end < by_position.size() && position(by_position[end]) == position(group); end++)
+                        group_of[by_position[end]] = group;
+                    first[group] = static_cast<GLuint>(begin);
+                    count[group] = static_cast<GLuint>(end - begin);
+                }
+            }
+
+            [[nodiscard]] std::pair<Ptr<GLuint const>, Ptr<GLuint const>> members(GLuint const group) const
+            {
+                auto const begin = by_position.data() + first[group];
+                return {begin, begin + count[group]};
+            }
+        };
+
+        // Groups that must stay: those on an edge used by any number of triangles but two, and those on a texture or
+        // color seam, whose vertices could not all find one with the same attributes at another position.
+        std::vector<bool> lockedGroups(
+            IndexedMesh const&         mesh,
+            PositionGroups const&      groups,
+            std::vector<GLuint> const& welded
+        )
+        {
+            std::vector<bool> locked(mesh.positions.size(), false);
+
+            for (std::size_t vertex = 0; vertex < mesh.positions.size(); vertex++)
+            {
+                auto const group = groups.group_of[vertex];
+                if (vertex == group) continue;
+
+                auto const seam = (mesh.has_textures && mesh.tex_coords[vertex] != mesh.tex_coords[group])
+                                  || (mesh.has_colors && mesh.colors[vertex] != mesh.colors[group]);
+                if (seam) locked[group] = true;
+            }
+
+            std::vector<std::pair<GLuint, GLuint>> edges;
+            edges.reserve(welded.size());
+            for (std::size_t i = 0; i < welded.size(); i += 3)
+            {
+                for (std::size_t corner = 0; corner < 3; corner++)
+                {
+                    auto const from = welded[i + corner], to = welded[i + (corner + 1) % 3];
+                    edges.emplace_back(std::min(from, to), std::max(from, to));
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            for (std::size_t begin = 0, end; begin < edges.size(); begin = end)
+            {
+                for (end = begin + 1; end < edges.size() && edges[end] == edges[begin]; end++) {}
+                if (end - begin == 2) continue;
+                locked[edges[begin].first] = locked[edges[begin].second] = true;
+            }
+            return locked;
+        }
+
+        // The vertex of the group whose attributes are closest to the vertex's, which takes its place in the
+        // triangles that are left once the vertex's position collapsed into the group's. Where the group is on a
+        // seam, that is the vertex on the side the triangles are on, elsewhere the one whose normal is closest.
+        GLuint closestInGroup(
+            IndexedMesh const&    mesh,
+            PositionGroups const& groups,
+            GLuint const          vertex,
+            GLuint const          group
+        )
+        {
+            auto const [begin, end] = groups.members(group);
+            if (end - begin == 1) return *begin;
+
+            auto const distance = [&](GLuint const other)
+            {
+                auto result = 0.f;
+                if (mesh.has_textures)
+                {
+                    auto const delta = mesh.tex_coords[other] - mesh.tex_coords[vertex];
+                    result += delta * delta;
+                }
+                if (mesh.has_colors)
+                {
+                    auto const delta = mesh.colors[other] - mesh.colors[vertex];
+                    result += delta * delta;
+                }
+                if (mesh.has_normals) result += 1 - dot(mesh.normals[other], mesh.normals[vertex]);
+                return result;
+            };
+            return *std::min_element(
+                begin,
+                end,
+                [&](GLuint const lhs, GLuint const rhs) { return distance(lhs) < distance(rhs); }
+            );
+        }
+
+        // Triangles using each vertex, in compressed rows like the optimizer's, rebuilt after every pass.
+        struct Adjacency
+        {
+            std::vector<GLuint> offsets;
+            std::vector<GLuint> triangles;
+
+            Adjacency(std::size_t const vertex_count, std::vector<GLuint> const& indices)
+                : offsets(vertex_count + 1, 0),
+                  triangles(indices.size())
+            {
+                for (auto const index : indices) { offsets[index + 1]++; }
+                std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+                auto cursor = std::vector<GLuint>(offsets.begin(), offsets.end() - 1);
+                for (std::size_t i = 0; i < indices.size(); i++)
+                    triangles[cursor[indices[i]]++] = static_cast<GLuint>(i / 3);
+            }
+        };
+
+        struct Collapse
+        {
+            GLuint from, to;
+            double cost;
+        };
+    }
+
+    SimplifiedMesh simplifyMesh(
+        IndexedMesh const&         mesh,
+        std::vector<GLuint> const& source,
+        std::size_t const          target_index_count
+    )
+    {
+        auto const& positions    = mesh.positions;
+        auto const  vertex_count = positions.size();
+
+        // The edges collapse between positions, with each corner keeping the vertex it uses at its position, so
+        // meshes whose every vertex is on a normal seam, like flat shaded ones, simplify too.
+        auto const groups = PositionGroups {mesh};
+        auto       indices = std::vector<GLuint>(source.size());
+        std::transform(
+            source.begin(),
+            source.end(),
+            indices.begin(),
+            [&](GLuint const vertex) { return groups.group_of[vertex]; }
+        );
+        auto       corners = source;
+        auto const locked  = lockedGroups(mesh, groups, indices);
+
+        std::vector<Quadric> quadrics(vertex_count, Quadric {});
+        for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            auto const& a = positions[indices[i]];
+            auto const  normal = normalOf(a, positions[indices[i + 1]], positions[indices[i + 2]]);
+            auto const  length = normal.magnitude();
+            if (length == 0) continue;
+
+            // The cross product's length is twice the triangle's area.
+            auto const unit  = normal * (1 / length);
+            auto const plane = Quadric::plane(unit, -dot(unit, a), length * 0.5);
+            for (std::size_t corner = 0; corner < 3; corner++) { quadrics[indices[i + corner]] += plane; }
+        }
+
+        double worst_cost = 0;
+
+        std::vector<GLuint>   remap(vertex_count);
+        std::vector<bool>     touched(vertex_count);
+        std::vector<unsigned> marks(vertex_count, 0);
+        unsigned              mark = 0;
+        std::vector<Collapse> collapses;
+        std::vector<GLuint>   shared;
+
+        // Every pass collapses the cheapest edges that do not share a triangle with each other, since one collapse
+        // changes what the others around it would cost, then rebuilds the triangles once.
+        while (indices.size() > target_index_count)
+        {
+            Adjacency const adjacency {vertex_count, indices};
+            auto const      around = [&](GLuint const vertex)
+            {
+                return std::pair {
+                    adjacency.triangles.begin() + adjacency.offsets[vertex],
+                    adjacency.triangles.begin() + adjacency.offsets[vertex + 1]
+                };
+            };
+
+            collapses.clear();
+            for (std::size_t i = 0; i < indices.size(); i += 3)
+            {
+                for (std::size_t corner = 0; corner < 3; corner++)
+                {
+                    auto const a = indices[i + corner], b = indices[i + (corner + 1) % 3];
+                    auto const cost = [&](GLuint const to, GLuint const from)
+                    {
+                        return (quadrics[from] + quadrics[to]).error(positions[to]);
+                    };
+                    if (!locked[a]) collapses.push_back({a, b, cost(b, a)});
+                    if (!locked[b]) collapses.push_back({b, a, cost(a, b)});
+                }
+            }
+            std::sort(
+                collapses.begin(),
+                collapses.end(),
+                [](Collapse const& lhs, Collapse const& rhs) { return lhs.cost < rhs.cost; }
+            );
+
+            // Each collapse of an interior edge removes two triangles.
+            auto const wanted = (indices.size() - target_index_count + 5) / 6;
+            auto       done   = std::size_t {0};
+            std::iota(remap.begin(), remap.end(), 0);
+            std::fill(touched.begin(), touched.end(), false);
+
+            for (auto const [from, to, cost] : collapses)
+            {
+                if (done == wanted) break;
+                if (touched[from] || touched[to]) continue;
+
+                auto const [first, last] = around(from);
+
+                // The edge's two triangles must be the only ones its ends share neighbours through, otherwise the
+                // collapse pinches the surface into a non-manifold one.
+                mark++;
+                for (auto triangle = first; triangle != last; triangle++)
+                    for (std::size_t corner = 0; corner < 3; corner++) marks[indices[*triangle * 3 + corner]] = mark;
+
+                shared.clear();
+                auto const [to_first, to_last] = around(to);
+                for (auto triangle = to_first; triangle != to_last; triangle++)
+                {
+                    for (std::size_t corner = 0; corner < 3; corner++)
+                    {
+                        auto const vertex = indices[*triangle * 3 + corner];
+                        if (vertex != from && vertex != to && marks[vertex] == mark) shared.push_back(vertex);
+                    }
+                }
+                std::sort(shared.begin(), shared.end());
+                if (std::unique(shared.begin(), shared.end()) - shared.begin() != 2) continue;
+
+                // Nor may any triangle that stays turn over once the vertex moves.
+                auto const flips = std::any_of(
+                    first,
+                    last,
+                    [&](GLuint const triangle)
+                    {
+                        auto const corners = &indices[triangle * 3];
+                        if (std::find(corners, corners + 3, to) != corners + 3) return false;
+
+                        auto const at    = [&](std::size_t const corner) { return positions[corners[corner]]; };
+                        auto const moved = [&](std::size_t const corner)
+                        {
+                            return corners[corner] == from ? positions[to] : at(corner);
+                        };
+                        auto const before = normalOf(at(0), at(1), at(2));
+                        auto const after  = normalOf(moved(0), moved(1), moved(2));
+                        return dot(before, after) <= 0;
+                    }
+                );
+                if (flips) continue;
+
+                remap[from] = to;
+                quadrics[to] += quadrics[from];
+                worst_cost = std::max(worst_cost, cost);
+                done++;
+
+                for (auto triangle = first; triangle != last; triangle++)
+                    for (std::size_t corner = 0; corner < 3; corner++) touched[indices[*triangle * 3 + corner]] = true;
+            }
+            if (done == 0) break;
+
+            // Triangles that had both ends of a collapsed edge are left with a repeated position.
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < indices.size(); i += 3)
+            {
+                auto const a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+                if (a == b || b == c || c == a) continue;
+
+                for (std::size_t corner = 0; corner < 3; corner++, kept++)
+                {
+                    auto const vertex = corners[i + corner];
+                    auto const group  = remap[indices[i + corner]];
+                    corners[kept] = group != indices[i + corner] ? closestInGroup(mesh, groups, vertex, group) : vertex;
+                    indices[kept] = group;
+                }
+            }
+            indices.resize(kept);
+            corners.resize(kept);
+        }
+
+        return {std::move(corners), static_cast<float>(std::sqrt(worst_cost))};
+    }
+
+    void buildLods(IndexedMesh& mesh, config::MeshOptimization const optimization)
+    {
+        auto const bounds = Box::of(mesh.positions);
+        auto const radius = bounds.isEmpty() ? 0.f : ((bounds.max - bounds.min) * 0.5f).magnitude();
+
+        mesh.lods.assign(1, {0, mesh.indexCount(), 0.f});
+        if (radius == 0) return;
+
+        auto previous = mesh.indices;
+        auto error    = 0.f;
+        while (mesh.lods.size() < MeshDescription::MaxLods)
+        {
+            auto const target = previous.size() / 6 * 3;
+            if (target < MinLodIndices) break;
+
+            auto [indices, level_error] = simplifyMesh(mesh, previous, target);
+            if (indices.size() > previous.size() * 3 / 4) break; // Too little left to gain for another draw range.
+
+            if (optimization == config::MeshOptimization::On)
+            {
+                IndexedMesh level;
+                level.positions = mesh.positions;
+                level.indices   = std::move(indices);
+                optimizeVertexCache(level);
+                indices = std::move(level.indices);
+            }
+
+            // Each level was simplified from the one before, so its distance from the full mesh adds up.
+            error += level_error;
+            mesh.lods.push_back({mesh.indexCount(), static_cast<GLsizei>(indices.size()), error / radius});
+            mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+            previous = std::move(indices);
+        }
+    }
+}
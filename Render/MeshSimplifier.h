@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Mesh.h"
+
+namespace render
+{
+    // Fewest indices a level of detail is built with, below which the draw call costs more than the triangles.
+    constexpr std::size_t MinLodIndices = 3 * 32;
+
+    struct SimplifiedMesh
+    {
+        std::vector<GLuint> indices;
+        float               error; // Distance from the planes of the triangles that were simplified, in model space.
+    };
+
+    // Collapses edges of the source triangles, which index the mesh's vertices, in order of their quadric error,
+    // following Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics" (1997), until at most
+    // target_index_count indices are left or no edge can collapse without folding the surface over. Every collapse
+    // merges a vertex into a neighbour instead of placing a new one, so the result still indexes the same vertices.
+    // Vertices sharing a position collapse together, each into the vertex at the kept position with the closest
+    // attributes, so flat shaded meshes simplify like smooth ones. Positions on open borders and on texture or color
+    // seams are never merged away, so neither holes nor texture seams move.
+    [[nodiscard]] SimplifiedMesh simplifyMesh(
+        IndexedMesh const&         mesh,
+        std::vector<GLuint> const& source,
+        std::size_t                target_index_count
+    );
+
+    // Appends ever coarser levels of detail to the mesh's indices, each with about half the triangles of the one
+    // before, and records where each of them is. Meant to run after optimizeMesh, which only knows the full mesh, and
+    // orders each level's triangles for the vertex cache too when asked to.
+    void buildLods(IndexedMesh& mesh, config::MeshOptimization optimization);
+}
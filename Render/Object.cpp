@@ -1,119 +1,141 @@
 ﻿#include "Object.h"
 
-#include <cassert>
+#include <algorithm>
 
-#include "Scene.h"
+#include "SceneGraph.h"
 
 namespace render
 {
-    Object::Object(
-        OptPtr<Object>               parent,
-        OptPtr<Mesh const> const     mesh,
-        Vector4 const                color,
-        OptPtr<Pipeline const> const shaders,
-        OptPtr<Texture const> const  texture
-    ) : parent {parent},
-        mesh {mesh},
-        shaders {shaders},
-        texture {texture},
-        color {color}
+    Object::Object(SceneGraph& graph, ObjectHandle const handle)
+        : graph_ {&graph},
+          handle_ {handle}
     {}
 
-    Object::Object(
-        OptPtr<Object> const         parent,
-        OptPtr<Pipeline const> const shaders,
-        OptPtr<Texture const> const  texture
-    ) : parent {parent},
-        mesh {nullptr},
-        shaders {shaders},
-        texture {texture},
-        color {Vector4::filled(1.0f)}
-    {}
+    Object Object::emplaceChild(
+        MeshHandle const     mesh,
+        Vector4 const        color,
+        PipelineHandle const shaders,
+        TextureHandle const  texture
+    ) const
+    {
+        return {*graph_, graph_->emplace(handle_, mesh, color, shaders, texture)};
+    }
+
+    Object Object::emplaceChild(PipelineHandle const shaders, TextureHandle const texture) const
+    {
+        return {*graph_, graph_->emplace(handle_, {}, Vector4::filled(1.0f), shaders, texture)};
+    }
+
+    void Object::remove() const { graph_->remove(handle_); }
 
-    void Object::animate()
+    bool Object::alive() const { return graph_->alive(handle_); }
+
+    std::optional<Object> Object::parent() const
     {
-        if (animation)
-        {
-            if (animation->active()) { animation->reverse(); }
-            else { animation->activate(); }
-        }
-        for (auto& child : children) { child.animate(); }
+        return graph_->objectAt(graph_->parents_[graph_->locate(handle_)]);
     }
 
-    void Object::update(double const elapsed_sec)
+    std::optional<Object> Object::firstChild() const
     {
-        if (animation && animation->active())
-            transform = animation->advance(elapsed_sec);
+        return graph_->objectAt(graph_->links_[graph_->locate(handle_)].first_child);
+    }
 
-        for (auto& child : children) { child.update(elapsed_sec); }
+    std::optional<Object> Object::lastChild() const
+    {
+        return graph_->objectAt(graph_->links_[graph_->locate(handle_)].last_child);
     }
 
-    void Object::draw(
-        Matrix4 const&               parent_transform,
-        OptPtr<Pipeline const> const parent_shaders,
-        Scene const&                 scene
-    ) const
+    std::optional<Object> Object::previousSibling() const
+    {
+        return graph_->objectAt(graph_->links_[graph_->locate(handle_)].previous);
+    }
+
+    std::optional<Object> Object::nextSibling() const
+    {
+        return graph_->objectAt(graph_->links_[graph_->locate(handle_)].next);
+    }
+
+    MeshHandle     Object::mesh() const { return graph_->draw_states_[graph_->locate(handle_)].mesh; }
+    PipelineHandle Object::shaders() const { return graph_->draw_states_[graph_->locate(handle_)].shaders; }
+    TextureHandle  Object::texture() const { return graph_->draw_states_[graph_->locate(handle_)].texture; }
+    OccluderHandle Object::occluder() const { return graph_->occluders_[graph_->locate(handle_)]; }
+
+    Material& Object::material() const
     {
-        auto const shaders = this->shaders != nullptr ? this->shaders : parent_shaders;
-        assert(shaders != nullptr);
+        auto const index = graph_->locate(handle_);
+        graph_->edited(index);
+        return graph_->materials_[index];
+    }
 
-        if (shaders != parent_shaders) { glUseProgram(shaders->programId()); }
-        {
-            auto const model_matrix = parent_transform * transform.toMatrix();
+    void Object::setMesh(MeshHandle const mesh) const
+    {
+        auto const index = graph_->locate(handle_);
+        graph_->edited(index);
+        graph_->draw_states_[index].mesh = mesh;
+        graph_->flags_[index] |= SceneGraph::Dirty; // So its bounds are recomputed.
+    }
 
-            if (auto const [r, g, b, alpha] = color; mesh != nullptr && alpha != 0)
-            {
-                glUniform4f(shaders->colorId(), r, g, b, alpha);
+    void Object::setShaders(PipelineHandle const shaders) const
+    {
+        auto const index = graph_->locate(handle_);
+        graph_->edited(index);
+        graph_->draw_states_[index].shaders = shaders;
+    }
 
-                if (auto const [r, g, b] = ambient_color; shaders->ambientId() != -1)
-                {
-                    glUniform3f(shaders->ambientId(), r, g, b);
-                }
+    void Object::setTexture(TextureHandle const texture) const
+    {
+        auto const index = graph_->locate(handle_);
+        graph_->edited(index);
+        graph_->draw_states_[index].texture = texture;
+    }
 
-                if (auto const [r, g, b] = specular_color; shaders->specularId() != -1)
-                {
-                    glUniform3f(shaders->specularId(), r, g, b);
-                    glUniform1f(shaders->shininessId(), shininess);
-                }
-                auto const texture_bind = texture != nullptr ? texture->texId() : scene.defaultTexture().texId();
-                glUniform1i(shaders->textureId(), 0);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, texture_bind);
+    void Object::setOccluder(OccluderHandle const occluder) const
+    {
+        auto const index = graph_->locate(handle_);
+        auto&      slot  = graph_->occluders_[index];
+        auto&      list  = graph_->occluding_;
+        if (!slot && occluder) list.push_back(index);
+        if (slot && !occluder) list.erase(std::find(list.begin(), list.end(), index));
+        slot = occluder;
+    }
 
-                glUniformMatrix4fv(shaders->modelId(), 1, GL_TRUE, model_matrix.inner);
-                glBindVertexArray(mesh->vaoId());
-                glDrawArrays(GL_TRIANGLES, 0, mesh->vertexCount());
-            }
-            for (auto const& child : children) { child.draw(model_matrix, shaders, scene); }
-        }
-        if (shaders != parent_shaders && parent_shaders != nullptr) { glUseProgram(parent_shaders->programId()); }
+    void Object::setAnimation(Animation const& animation) const
+    {
+        auto const index = graph_->locate(handle_);
+        auto&      slot  = graph_->animations_[index];
+        graph_->edited(index, true);
+        if (!slot) graph_->animated_.push_back(index);
+        slot = animation;
     }
 
-    Object& Object::emplaceChild(
-        OptPtr<Mesh const>     mesh,
-        Vector4                color,
-        OptPtr<Pipeline const> shaders,
-        OptPtr<Texture const>  texture
-    )
+    Transform const& Object::transform() const { return graph_->transforms_[graph_->locate(handle_)]; }
+    Matrix4 const&   Object::worldMatrix() const { return graph_->world_matrices_[graph_->locate(handle_)]; }
+
+    void Object::setTransform(Transform const& transform) const
     {
-        return children.emplace_back(this, mesh, color, shaders, texture);
+        auto const index = graph_->locate(handle_);
+        graph_->edited(index, true);
+        graph_->transforms_[index] = transform;
+        graph_->flags_[index] |= SceneGraph::Dirty;
     }
 
-    Object& Object::emplaceChild(OptPtr<Pipeline const> shaders, OptPtr<Texture const> texture)
+    Transform& Object::editTransform() const
     {
-        return children.emplace_back(this, shaders, texture);
+        auto const index = graph_->locate(handle_);
+        graph_->edited(index, true);
+        graph_->flags_[index] |= SceneGraph::Dirty;
+        return graph_->transforms_[index];
     }
 
-    bool Object::removeChild(Ptr<Object> const child)
+    void Object::freeze() const { graph_->freeze(graph_->locate(handle_)); }
+    void Object::thaw() const
     {
-        for (auto iter = children.begin(), end = children.end(); iter == end; ++iter)
-        {
-            if (&*iter == child)
-            {
-                children.erase(iter);
-                return true;
-            }
-        }
-        return false;
+        if (auto const index = graph_->locate(handle_); graph_->flags_[index] & SceneGraph::Frozen) graph_->thaw(index);
     }
+    bool Object::frozen() const { return graph_->flags_[graph_->locate(handle_)] & SceneGraph::Frozen; }
+
+    ObjectHandle Object::handle() const { return handle_; }
+
+    bool Object::operator==(Object const& other) const { return graph_ == other.graph_ && handle_ == other.handle_; }
+    bool Object::operator!=(Object const& other) const { return !(*this == other); }
 }
@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <optional>
+
 #include "Mesh.h"
 #include "Shader.h"
 #include "Texture.h"
@@ -8,55 +10,81 @@
 
 namespace render
 {
-    class Scene;
+    class Object;
+    class SceneGraph;
+
+    struct Material
+    {
+        Vector4 color;
+        Vector3 ambient_color  = Vector3::filled(0.11f);
+        Vector3 specular_color = Vector3::filled(0.15f);
+        float   shininess      = 32;
+    };
+
+    using ObjectHandle = Handle<Object>;
 
-    struct Object
+    // Proxy for an object stored in a SceneGraph, cheap to copy. It keeps working after other objects are added or
+    // removed, and once its own object is removed every access throws. References it hands out point into the graph's
+    // arrays, so they only last until the next object is added or the graph is compacted.
+    class Object
     {
-        [[nodiscard]] explicit Object(
-            OptPtr<Object>         parent,
-            OptPtr<Mesh const>     mesh,
-            Vector4                color,
-            OptPtr<Pipeline const> shaders = nullptr,
-            OptPtr<Texture const>  texture = nullptr
-        );
-
-        [[nodiscard]] explicit Object(
-            OptPtr<Object>         parent  = nullptr,
-            OptPtr<Pipeline const> shaders = nullptr,
-            OptPtr<Texture const>  texture = nullptr
-        );
-
-        void animate();
-        void update(double elapsed_sec);
-        void draw(Matrix4 const& parent_transform, OptPtr<Pipeline const> parent_shaders, Scene const& scene) const;
-
-        Object& emplaceChild(
-            OptPtr<Mesh const>     mesh,
-            Vector4                color,
-            OptPtr<Pipeline const> shaders = nullptr,
-            OptPtr<Texture const>  texture = nullptr
-        );
-
-        Object& emplaceChild(
-            OptPtr<Pipeline const> shaders = nullptr,
-            OptPtr<Texture const>  texture = nullptr
-        );
-
-        bool removeChild(Ptr<Object> child);
-
-        OptPtr<Object> parent;
-
-        OptPtr<Mesh const>     mesh;
-        OptPtr<Pipeline const> shaders;
-        OptPtr<Texture const>  texture;
-
-        Vector4   color;
-        Vector3   ambient_color  = Vector3::filled(0.11f);
-        Vector3   specular_color = Vector3::filled(0.15f);
-        float     shininess      = 32;
-        Transform transform;
-
-        std::optional<Animation> animation;
-        std::list<Object>        children;
+        Ptr<SceneGraph> graph_;
+        ObjectHandle    handle_;
+
+    public:
+        Object(SceneGraph& graph, ObjectHandle handle);
+
+        Object emplaceChild(
+            MeshHandle     mesh,
+            Vector4        color,
+            PipelineHandle shaders = {},
+            TextureHandle  texture = {}
+        ) const;
+
+        Object emplaceChild(PipelineHandle shaders = {}, TextureHandle texture = {}) const;
+
+        // Removes the object along with everything below it.
+        void remove() const;
+
+        [[nodiscard]] bool alive() const;
+
+        [[nodiscard]] std::optional<Object> parent() const;
+        [[nodiscard]] std::optional<Object> firstChild() const;
+        [[nodiscard]] std::optional<Object> lastChild() const;
+        [[nodiscard]] std::optional<Object> previousSibling() const;
+        [[nodiscard]] std::optional<Object> nextSibling() const;
+
+        [[nodiscard]] MeshHandle     mesh() const;
+        [[nodiscard]] PipelineHandle shaders() const; // Null when the parent's are used.
+        [[nodiscard]] TextureHandle  texture() const;
+        [[nodiscard]] Material&      material() const; // Thaws like any edit, since the material can change through it.
+        [[nodiscard]] OccluderHandle occluder() const; // Null unless the object hides what is behind it.
+
+        void setMesh(MeshHandle mesh) const;
+        void setShaders(PipelineHandle shaders) const;
+        void setTexture(TextureHandle texture) const;
+        void setAnimation(Animation const& animation) const;
+        // Rasterizes the occluder in the object's place each frame, so that objects behind it are not drawn. It must
+        // lie within what the object draws, and only hides anything while the object is opaque.
+        void setOccluder(OccluderHandle occluder) const;
+
+        [[nodiscard]] Transform const& transform() const;
+        [[nodiscard]] Matrix4 const&   worldMatrix() const; // As of the last update.
+
+        // Both mark the object as moved, so its world matrix and its children's are recomputed on the next update.
+        void       setTransform(Transform const& transform) const;
+        Transform& editTransform() const;
+
+        // Draws the object and everything below it as a few merged meshes from the next frame on, baked where they
+        // are then relative to the object. The object itself may still move and animate, but any other edit of it or
+        // below it thaws the subtree again, as does freezing anything above or below it.
+        void               freeze() const;
+        void               thaw() const;
+        [[nodiscard]] bool frozen() const;
+
+        [[nodiscard]] ObjectHandle handle() const;
+
+        bool operator==(Object const& other) const;
+        bool operator!=(Object const& other) const;
     };
 }
@@ -0,0 +1,276 @@
+﻿#include "Occlusion.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#include <emmintrin.h>
+
+namespace render
+{
+    namespace
+    {
+        constexpr float GuardBand = 2; // Half screens around the center that triangles are clipped to.
+
+        // Planes that triangles are clipped against in clip space, keeping the points p with dot(plane, p) >= 0. The
+        // near plane keeps w positive, and the guard band keeps the pixel coordinates small enough for the edge
+        // functions to stay accurate.
+        constexpr Vector4 ClipPlanes[] = {
+            {0, 0, 1, 1},
+            {1, 0, 0, GuardBand},
+            {-1, 0, 0, GuardBand},
+            {0, 1, 0, GuardBand},
+            {0, -1, 0, GuardBand},
+        };
+
+        // Clipping a convex polygon against a plane adds at most one vertex.
+        constexpr std::size_t MaxClipped = 3 + std::size(ClipPlanes);
+
+        using Polygon = std::array<Vector4, MaxClipped>;
+
+        float dot(Vector4 const left, Vector4 const right)
+        {
+            return left.x * right.x + left.y * right.y + left.z * right.z + left.w * right.w;
+        }
+
+        // Unlike Matrix4 * Vector4, keeps the w the matrix computes.
+        Vector4 toClipSpace(Matrix4 const& matrix, Vector3 const point)
+        {
+            auto const row = [&](std::size_t const index)
+            {
+                auto const m = [&](std::size_t const column) { return matrix[index * 4 + column]; };
+                return m(0) * point.x + m(1) * point.y + m(2) * point.z + m(3);
+            };
+            return {row(0), row(1), row(2), row(3)};
+        }
+
+        // Clips the polygon against every plane in turn, returning how many vertices are left.
+        std::size_t clip(Polygon& polygon, std::size_t count)
+        {
+            Polygon clipped;
+            for (auto const plane : ClipPlanes)
+            {
+                std::size_t kept = 0;
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    auto const from = polygon[i], to = polygon[(i + 1) % count];
+                    auto const from_distance = dot(plane, from), to_distance = dot(plane, to);
+
+                    if (from_distance >= 0) clipped[kept++] = from;
+                    if ((from_distance >= 0) != (to_distance >= 0))
+                        clipped[kept++] = from + (to - from) * (from_distance / (from_distance - to_distance));
+                }
+                if (kept < 3) return 0;
+
+                polygon = clipped;
+                count   = kept;
+            }
+            return count;
+        }
+
+        // Pixel coordinates, with y going up like in NDC, and the depth as 1 / w.
+        Vector3 toScreen(Vector4 const clipped)
+        {
+            auto const inverse_w = 1 / clipped.w;
+            return {
+                (clipped.x * inverse_w * 0.5f + 0.5f) * OcclusionBuffer::Width,
+                (clipped.y * inverse_w * 0.5f + 0.5f) * OcclusionBuffer::Height,
+                inverse_w
+            };
+        }
+    }
+
+    OcclusionBuffer::OcclusionBuffer()
+        : depth_(static_cast<std::size_t>(Width) * Height, 0.f)
+    {
+        static_assert(Width % 4 == 0 && Height % BandHeight == 0);
+    }
+
+    void OcclusionBuffer::clear(Matrix4 const& view_projection)
+    {
+        view_projection_ = view_projection;
+        triangles_.clear();
+    }
+
+    void OcclusionBuffer::add(OccluderMesh const& occluder, Matrix4 const& world)
+    {
+        auto const matrix = view_projection_ * world;
+
+        clip_space_.clear();
+        for (auto const position : occluder.positions) { clip_space_.push_back(toClipSpace(matrix, position)); }
+
+        for (std::size_t i = 0; i + 2 < occluder.indices.size(); i += 3)
+        {
+            Polygon polygon;
+            for (std::size_t corner = 0; corner < 3; corner++)
+                polygon[corner] = clip_space_[occluder.indices[i + corner]];
+
+            // What is left after clipping is convex, so it is set up as a fan of triangles.
+            auto const count = clip(polygon, 3);
+            for (std::size_t corner = 1; corner + 1 < count; corner++)
+                setup(toScreen(polygon[0]), toScreen(polygon[corner]), toScreen(polygon[corner + 1]));
+        }
+    }
+
+    void OcclusionBuffer::rasterize(engine::JobSystem& jobs)
+    {
+        // Without occluders nothing is occluded, which occluded() checks before reading the stale depths.
+        if (triangles_.empty()) return;
+
+        jobs.parallelFor(
+            Height / BandHeight,
+            1,
+            [this](std::size_t const begin, std::size_t const end)
+            {
+                for (auto band = begin; band < end; band++) { rasterizeBand(static_cast<int>(band)); }
+            }
+        );
+    }
+
+    bool OcclusionBuffer::occluded(Box const& box) const
+    {
+        if (triangles_.empty() || box.isEmpty()) return false;
+
+        constexpr auto Infinity = std::numeric_limits<float>::infinity();
+
+        auto low = Vector2::filled(Infinity), high = Vector2::filled(-Infinity);
+        auto nearest = 0.f;
+        for (auto corner = 0; corner < 8; corner++)
+        {
+            auto const point = Vector3 {
+                corner & 1 ? box.max.x : box.min.x,
+                corner & 2 ? box.max.y : box.min.y,
+                corner & 4 ? box.max.z : box.min.z
+            };
+            auto const clipped = toClipSpace(view_projection_, point);
+            if (clipped.w <= 0 || clipped.z < -clipped.w) return false;
+
+            auto const [x, y, inverse_w] = toScreen(clipped);
+            low     = {std::min(low.x, x), std::min(low.y, y)};
+            high    = {std::max(high.x, x), std::max(high.y, y)};
+            nearest = std::max(nearest, inverse_w);
+        }
+
+        // Every pixel the box's rectangle touches, even along an edge. Boxes off screen are left to the frustum.
+        auto const min_x = static_cast<int>(std::floor(std::max(low.x, 0.f)));
+        auto const min_y = static_cast<int>(std::floor(std::max(low.y, 0.f)));
+        auto const max_x = static_cast<int>(std::floor(std::min(high.x, Width - 1.f)));
+        auto const max_y = static_cast<int>(std::floor(std::min(high.y, Height - 1.f)));
+        if (min_x > max_x || min_y > max_y) return false;
+
+        auto const lanes   = _mm_setr_ps(0, 1, 2, 3);
+        auto const first   = _mm_set1_ps(static_cast<float>(min_x));
+        auto const last    = _mm_set1_ps(static_cast<float>(max_x));
+        auto const closest = _mm_set1_ps(nearest);
+        for (auto y = min_y; y <= max_y; y++)
+        {
+            auto const row = depth_.data() + static_cast<std::ptrdiff_t>(y) * Width;
+            for (auto x = min_x & ~3; x <= max_x; x += 4)
+            {
+                auto const xs      = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes);
+                auto const covered = _mm_and_ps(_mm_cmpge_ps(xs, first), _mm_cmple_ps(xs, last));
+                auto const visible = _mm_and_ps(covered, _mm_cmple_ps(_mm_loadu_ps(row + x), closest));
+                if (_mm_movemask_ps(visible) != 0) return false;
+            }
+        }
+        return true;
+    }
+
+    std::size_t OcclusionBuffer::triangleCount() const { return triangles_.size(); }
+
+    void OcclusionBuffer::setup(Vector3 const a, Vector3 const b, Vector3 const c)
+    {
+        // Counter clockwise on screen is front facing, back faces are culled when drawn so they hide nothing.
+        auto const area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+        if (!(area > 0)) return;
+
+        Triangle triangle {};
+        triangle.min_x = std::max(0, static_cast<int>(std::floor(std::min({a.x, b.x, c.x}))));
+        triangle.min_y = std::max(0, static_cast<int>(std::floor(std::min({a.y, b.y, c.y}))));
+        triangle.max_x = std::min(Width - 1, static_cast<int>(std::ceil(std::max({a.x, b.x, c.x}))) - 1);
+        triangle.max_y = std::min(Height - 1, static_cast<int>(std::ceil(std::max({a.y, b.y, c.y}))) - 1);
+        if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) return;
+
+        // The planes are evaluated at the pixels' lower left corners, shifted by half a pixel to their centers and by
+        // the plane's reach across a pixel, so they give the smallest value within each pixel.
+        auto const at_worst = [](float const dx, float const dy, float const value_at_origin)
+        {
+            return value_at_origin + (dx + dy) * 0.5f - (std::abs(dx) + std::abs(dy)) * 0.5f;
+        };
+
+        Vector3 const corners[3] = {a, b, c};
+        for (std::size_t edge = 0; edge < 3; edge++)
+        {
+            auto const from = corners[edge], to = corners[(edge + 1) % 3];
+            auto const dx   = from.y - to.y;
+            auto const dy   = to.x - from.x;
+
+            triangle.edge_x[edge] = dx;
+            triangle.edge_y[edge] = dy;
+            triangle.edge_c[edge] = at_worst(dx, dy, -(dx * from.x + dy * from.y));
+        }
+
+        // 1 / w over the pixels, from the plane through the three corners.
+        auto const ab = b - a, ac = c - a;
+        auto const dx = -(ab.y * ac.z - ab.z * ac.y) / area;
+        auto const dy = -(ab.z * ac.x - ab.x * ac.z) / area;
+
+        triangle.depth_x = dx;
+        triangle.depth_y = dy;
+        triangle.depth_c = at_worst(dx, dy, a.z - dx * a.x - dy * a.y);
+
+        triangles_.push_back(triangle);
+    }
+
+    void OcclusionBuffer::rasterizeBand(int const band)
+    {
+        auto const first_row = band * BandHeight, last_row = first_row + BandHeight - 1;
+        auto const band_data = depth_.data() + static_cast<std::ptrdiff_t>(first_row) * Width;
+        std::fill(band_data, band_data + BandHeight * Width, 0.f);
+
+        auto const lanes = _mm_setr_ps(0, 1, 2, 3);
+        auto const zero  = _mm_setzero_ps();
+        for (auto const& triangle : triangles_)
+        {
+            auto const& [edge_x, edge_y, edge_c, depth_x, depth_y, depth_c, min_x, max_x, min_y, max_y] = triangle;
+
+            auto const top = std::max(min_y, first_row), bottom = std::min(max_y, last_row);
+            if (top > bottom) continue;
+
+            __m128 step_x[3];
+            for (std::size_t edge = 0; edge < 3; edge++) { step_x[edge] = _mm_set1_ps(edge_x[edge]); }
+            auto const depth_step_x = _mm_set1_ps(depth_x);
+
+            for (auto y = top; y <= bottom; y++)
+            {
+                auto const row = depth_.data() + static_cast<std::ptrdiff_t>(y) * Width;
+
+                __m128 at_row[3];
+                for (std::size_t edge = 0; edge < 3; edge++)
+                    at_row[edge] = _mm_set1_ps(edge_y[edge] * static_cast<float>(y) + edge_c[edge]);
+                auto const depth_at_row = _mm_set1_ps(depth_y * static_cast<float>(y) + depth_c);
+
+                // Pixels of the first and last 4 that lie outside the triangle's bounds fail the edge tests, since
+                // none of them is entirely covered.
+                for (auto x = min_x & ~3; x <= max_x; x += 4)
+                {
+                    auto const xs = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes);
+
+                    auto inside = _mm_cmpgt_ps(_mm_add_ps(_mm_mul_ps(step_x[0], xs), at_row[0]), zero);
+                    for (std::size_t edge = 1; edge < 3; edge++)
+                    {
+                        auto const value = _mm_add_ps(_mm_mul_ps(step_x[edge], xs), at_row[edge]);
+                        inside           = _mm_and_ps(inside, _mm_cmpgt_ps(value, zero));
+                    }
+                    if (_mm_movemask_ps(inside) == 0) continue;
+
+                    // The buffer never holds negative depths, so the zeros of uncovered pixels leave it as it was.
+                    auto const depth = _mm_add_ps(_mm_mul_ps(depth_step_x, xs), depth_at_row);
+                    _mm_storeu_ps(row + x, _mm_max_ps(_mm_loadu_ps(row + x), _mm_and_ps(inside, depth)));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Bounds.h"
+#include "Mesh.h"
+#include "../Engine/JobSystem.h"
+#include "../Math/Matrix.h"
+#include "../Math/Vector.h"
+
+namespace render
+{
+    // Low resolution depth buffer the designated occluders are rasterized into on the CPU every frame, so that objects
+    // hidden behind them are dropped before they are submitted. Depths are stored as 1 / w, which is linear across a
+    // triangle on screen, with 0 where nothing was drawn.
+    //
+    // The rasterization is inner conservative: a pixel is only covered when the triangle covers all of it, and then
+    // holds the farthest depth the triangle has within it. An object is therefore only reported as occluded when it
+    // would be hidden at any resolution, no matter how coarse the buffer is.
+    class OcclusionBuffer
+    {
+    public:
+        static constexpr int Width      = 256; // A multiple of the 4 pixels rasterized at once.
+        static constexpr int Height     = 128;
+        static constexpr int BandHeight = 16; // Rows rasterized by a single job.
+
+    private:
+        // Triangle in pixel coordinates, with its edge functions and depth as planes over the pixels' corners.
+        struct Triangle
+        {
+            float edge_x[3], edge_y[3], edge_c[3]; // A pixel is covered where all three are positive.
+            float depth_x, depth_y, depth_c;
+            int   min_x, max_x, min_y, max_y;      // Pixels it may cover, inclusive.
+        };
+
+        Matrix4               view_projection_ = Matrix4::identity();
+        std::vector<float>    depth_;
+        std::vector<Triangle> triangles_;
+
+        std::vector<Vector4> clip_space_; // Scratch space of adding an occluder.
+
+    public:
+        OcclusionBuffer();
+
+        // Starts over for a frame seen through the view projection, which is row major like every other matrix here.
+        void clear(Matrix4 const& view_projection);
+        // Sets up the occluder's front facing triangles, clipped to the near plane, to be rasterized with the rest.
+        void add(OccluderMesh const& occluder, Matrix4 const& world);
+        // Rasterizes every triangle added since the last clear, one band of rows per job.
+        void rasterize(engine::JobSystem& jobs);
+
+        // Whether the box, in world space, is entirely behind what was rasterized. Boxes reaching in front of the near
+        // plane never are.
+        [[nodiscard]] bool occluded(Box const& box) const;
+
+        [[nodiscard]] std::size_t triangleCount() const;
+
+    private:
+        void setup(Vector3 a, Vector3 b, Vector3 c);
+        void rasterizeBand(int band);
+    };
+}
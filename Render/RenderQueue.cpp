@@ -0,0 +1,304 @@
+﻿#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+#include "GlState.h"
+
+namespace render
+{
+    namespace
+    {
+        constexpr std::uint64_t TranslucentBit = std::uint64_t {1} << 63;
+
+        // GL names are small in practice. A name too large for its field only costs grouping, never correctness,
+        // since every item carries its whole state.
+        constexpr unsigned ProgramShift = 40, TextureShift = 20, VaoShift = 2;
+        constexpr unsigned ProgramBits  = 23, TextureBits = 20, VaoBits = 18, LodBits = 2;
+
+        static_assert(MeshDescription::MaxLods <= 1u << LodBits);
+
+        constexpr std::size_t NotInstanced = ~std::size_t {0};
+
+        std::uint64_t field(GLuint const name, unsigned const bits)
+        {
+            return std::uint64_t {name} & ((std::uint64_t {1} << bits) - 1);
+        }
+
+        bool sameState(RenderQueue::Item const& lhs, RenderQueue::Item const& rhs)
+        {
+            return lhs.pipeline == rhs.pipeline && lhs.texture == rhs.texture && lhs.mesh == rhs.mesh
+                   && lhs.lod == rhs.lod;
+        }
+
+        // Whether the item can be drawn by a command of a multi-draw, which is when its mesh is in the arena and its
+        // instance attributes are found through the command's base instance.
+        bool multiDrawn(RenderQueue::Item const& item)
+        {
+            return item.mesh->inArena() && item.pipeline->instanced() != nullptr;
+        }
+
+        // Whether the items can be drawn by the same multi-draw, which only needs them to share the VAO. Opaque and
+        // translucent items are kept apart, since only the opaque ones may be culled on the GPU.
+        bool sameMultiDraw(RenderQueue::Item const& lhs, RenderQueue::Item const& rhs)
+        {
+            return multiDrawn(lhs) && multiDrawn(rhs) && lhs.pipeline == rhs.pipeline && lhs.texture == rhs.texture
+                   && lhs.mesh->vaoId() == rhs.mesh->vaoId()
+                   && (lhs.material.color.w < 1) == (rhs.material.color.w < 1);
+        }
+
+        Instance instanceOf(RenderQueue::Item const& item)
+        {
+            auto const& material = item.material;
+            return {
+                item.model.transposed(),
+                material.color,
+                material.ambient_color,
+                material.specular_color,
+                material.shininess
+            };
+        }
+    }
+
+    void RenderQueue::clear()
+    {
+        items_.clear();
+        entries_.clear();
+    }
+
+    void RenderQueue::push(Item const& item)
+    {
+        entries_.push_back({keyOf(item), meshKeyOf(item), static_cast<std::uint32_t>(items_.size())});
+        items_.push_back(item);
+    }
+
+    void RenderQueue::submit(Pipeline const& default_shaders, FrameRing& ring, OptPtr<GpuCulling> const culling)
+    {
+        // Equal keys keep the order the items were pushed in, which is all that orders the translucent ones.
+        std::sort(
+            entries_.begin(),
+            entries_.end(),
+            [](Entry const& lhs, Entry const& rhs)
+            {
+                return std::tie(lhs.key, lhs.mesh, lhs.item) < std::tie(rhs.key, rhs.mesh, rhs.item);
+            }
+        );
+
+        auto const itemOf = [this](Run const& run) -> Item const& { return items_[entries_[run.begin].item]; };
+        auto const gpuCulled = [culling](Item const& item)
+        {
+            return culling != nullptr && culledOnGpu(*item.pipeline, *item.mesh, item.material);
+        };
+
+        // Items sharing their state are next to each other once sorted, unless they are translucent and something
+        // else was pushed between them. The runs are found first, so the instances take a single slice of the ring.
+        runs_.clear();
+        std::size_t instance_count = 0, command_count = 0;
+        for (std::uint32_t begin = 0, end; begin < entries_.size(); begin = end)
+        {
+            auto const& first = items_[entries_[begin].item];
+            for (end = begin + 1; end < entries_.size() && sameState(first, items_[entries_[end].item]); end++) {}
+
+            if (first.pipeline->instanced() == nullptr) runs_.push_back({begin, end, NotInstanced});
+            else runs_.push_back({begin, end, std::exchange(instance_count, instance_count + (end - begin))});
+            if (multiDrawn(first) && !gpuCulled(first)) command_count++;
+        }
+
+        // Past the last run drawn by the same call as the one given.
+        auto const drawnUntil = [&](std::vector<Run>::const_iterator run)
+        {
+            auto const& first = itemOf(*run);
+            for (++run; run != runs_.cend() && sameMultiDraw(first, itemOf(*run)); ++run) {}
+            return run;
+        };
+
+        auto const instances = ring.allocate(instance_count * sizeof(Instance), alignof(Instance));
+        auto       written   = instances.data;
+        for (auto const [begin, end, first_instance] : runs_)
+        {
+            if (first_instance == NotInstanced) continue;
+            for (auto entry = begin; entry < end; entry++, written += sizeof(Instance))
+            {
+                auto const instance = instanceOf(items_[entries_[entry].item]);
+                std::memcpy(written, &instance, sizeof(Instance));
+            }
+        }
+
+        // The items culled on the GPU are all culled by a single dispatch before anything is drawn. Each is drawn by a
+        // command of its own, as the single instance of its item.
+        culled_objects_.clear();
+        auto culled_draws = std::size_t {0};
+        for (auto run = runs_.cbegin(), end = run; run != runs_.cend(); run = end)
+        {
+            end = drawnUntil(run);
+            if (!gpuCulled(itemOf(*run))) continue;
+
+            auto const first_command = static_cast<GLuint>(culled_objects_.size());
+            for (auto drawn = run; drawn != end; ++drawn)
+            {
+                for (auto entry = drawn->begin; entry < drawn->end; entry++)
+                {
+                    auto const& item   = items_[entries_[entry].item];
+                    auto const  center = (item.bounds.min + item.bounds.max) * .5f;
+                    auto const  extent = (item.bounds.max - item.bounds.min) * .5f;
+                    culled_objects_.push_back({
+                        {center.x, center.y, center.z, 0},
+                        {extent.x, extent.y, extent.z, 0},
+                        static_cast<GLuint>(item.mesh->lod(item.lod).index_count),
+                        item.mesh->firstIndex(item.lod),
+                        item.mesh->baseVertex(),
+                        static_cast<GLuint>(drawn->first_instance + (entry - drawn->begin)),
+                        static_cast<GLuint>(culled_draws),
+                        first_command,
+                        {}
+                    });
+                }
+            }
+            culled_draws++;
+        }
+        auto const culled = culling != nullptr ? culling->cull(ring, culled_objects_, culled_draws)
+                                               : GpuCulling::Culled {};
+
+        // Runs of arena meshes sharing the rest of their state are drawn by a single call, with a command for each
+        // run that finds its instances through its base instance.
+        auto const commands      = ring.allocate(command_count * sizeof(DrawCommand), alignof(DrawCommand));
+        auto       command       = std::size_t {0};
+        auto       culled_draw   = std::size_t {0};
+        auto       culled_object = std::size_t {0};
+
+        // The state only changes between runs, the state cache skips the rest.
+        auto& state = GlState::current();
+        draw_count_ = 0;
+        for (auto run = runs_.cbegin(); run != runs_.cend(); ++run)
+        {
+            auto const [begin, end, first_instance] = *run;
+            if (first_instance != NotInstanced)
+            {
+                auto const& first     = itemOf(*run);
+                auto const& instanced = *first.pipeline->instanced();
+                state.useProgram(instanced.programId());
+                state.bindTexture(0, first.texture);
+                state.bindVertexArray(first.mesh->vaoId());
+
+                state.uniform(instanced.textureId(), 0);
+                if (first.mesh->inArena())
+                {
+                    glBindVertexBuffer(Mesh::InstanceBinding, instances.buffer, instances.offset, sizeof(Instance));
+
+                    auto const last = drawnUntil(run) - 1;
+                    if (gpuCulled(first))
+                    {
+                        auto const object_count = std::accumulate(
+                            run,
+                            last + 1,
+                            std::size_t {0},
+                            [](std::size_t const sum, Run const& drawn) { return sum + (drawn.end - drawn.begin); }
+                        );
+                        GpuCulling::draw(culled, culled_draw++, culled_object, object_count);
+                        culled_object += object_count;
+                        run = last;
+                        draw_count_++;
+                        continue;
+                    }
+
+                    auto const first_command = command;
+                    for (;; ++run)
+                    {
+                        auto const& item    = itemOf(*run);
+                        auto const  written = DrawCommand {
+                            static_cast<GLuint>(item.mesh->lod(item.lod).index_count),
+                            run->end - run->begin,
+                            item.mesh->firstIndex(item.lod),
+                            item.mesh->baseVertex(),
+                            static_cast<GLuint>(run->first_instance)
+                        };
+                        std::memcpy(commands.data + command++ * sizeof(DrawCommand), &written, sizeof(DrawCommand));
+                        if (run == last) break;
+                    }
+
+                    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.buffer);
+                    glMultiDrawElementsIndirect(
+                        GL_TRIANGLES,
+                        GL_UNSIGNED_INT,
+                        reinterpret_cast<void const*>(commands.offset + first_command * sizeof(DrawCommand)),
+                        static_cast<GLsizei>(command - first_command),
+                        0
+                    );
+                    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+                    draw_count_++;
+                    continue;
+                }
+
+                auto const mesh = first.mesh;
+                auto const lod  = first.lod;
+                glBindVertexBuffer(
+                    Mesh::InstanceBinding,
+                    instances.buffer,
+                    instances.offset + static_cast<GLintptr>(first_instance * sizeof(Instance)),
+                    sizeof(Instance)
+                );
+                glDrawElementsInstancedBaseVertex(
+                    GL_TRIANGLES,
+                    mesh->lod(lod).index_count,
+                    mesh->indexType(),
+                    mesh->lodIndices(lod),
+                    static_cast<GLsizei>(end - begin),
+                    mesh->baseVertex()
+                );
+                draw_count_++;
+                continue;
+            }
+
+            for (auto entry = begin; entry < end; entry++)
+            {
+                auto const& [shaders, texture, mesh, lod, model, material, _] = items_[entries_[entry].item];
+                state.useProgram(shaders->programId());
+                state.bindTexture(0, texture);
+                state.bindVertexArray(mesh->vaoId());
+
+                state.uniform(shaders->textureId(), 0);
+                state.uniform(shaders->colorId(), material.color);
+                state.uniform(shaders->ambientId(), material.ambient_color);
+                state.uniform(shaders->specularId(), material.specular_color);
+                state.uniform(shaders->shininessId(), material.shininess);
+                state.uniform(shaders->modelId(), model);
+                glDrawElementsBaseVertex(
+                    GL_TRIANGLES,
+                    mesh->lod(lod).index_count,
+                    mesh->indexType(),
+                    const_cast<void*>(mesh->lodIndices(lod)), // GLEW leaves out the const of this one.
+                    mesh->baseVertex()
+                );
+                draw_count_++;
+            }
+        }
+        state.useProgram(default_shaders.programId());
+    }
+
+    std::size_t RenderQueue::size() const { return items_.size(); }
+    std::size_t RenderQueue::drawCount() const { return draw_count_; }
+
+    std::uint64_t RenderQueue::keyOf(Item const& item)
+    {
+        if (item.material.color.w < 1) return TranslucentBit;
+
+        return field(item.pipeline->programId(), ProgramBits) << ProgramShift
+               | field(item.texture, TextureBits) << TextureShift
+               | field(item.mesh->vaoId(), VaoBits) << VaoShift
+               | field(item.lod, LodBits);
+    }
+
+    std::uint32_t RenderQueue::meshKeyOf(Item const& item)
+    {
+        if (item.material.color.w < 1 || !item.mesh->inArena()) return 0;
+        return item.mesh->firstIndex(0);
+    }
+
+    bool RenderQueue::culledOnGpu(Pipeline const& pipeline, Mesh const& mesh, Material const& material)
+    {
+        return mesh.inArena() && pipeline.instanced() != nullptr && material.color.w >= 1;
+    }
+}
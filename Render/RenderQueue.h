@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Bounds.h"
+#include "FrameRing.h"
+#include "GpuCulling.h"
+#include "Mesh.h"
+#include "Object.h"
+#include "Shader.h"
+#include "../Math/Matrix.h"
+#include "../Utils.h"
+
+namespace render
+{
+    // Draws collected from the scene and submitted sorted by the state they need, so that objects sharing a program,
+    // texture or mesh are drawn in runs instead of switching state between every draw. Translucent draws go last and
+    // keep the order they were pushed in, since blending depends on it. Runs of items sharing all of their state are
+    // drawn in a single instanced call when their pipeline has an instanced variant, with their model matrices and
+    // materials streamed into a frame ring instead of set as uniforms. Instanced runs of meshes in the geometry arena
+    // that share their pipeline and texture are drawn together by a single multi-draw, whatever their meshes. With
+    // culling on the GPU, the opaque ones are instead frustum culled by a compute shader, which writes the commands of
+    // those multi-draws with an instance for each visible item.
+    class RenderQueue
+    {
+    public:
+        struct Item
+        {
+            Ptr<Pipeline const> pipeline;
+            GLuint              texture;
+            Ptr<Mesh const>     mesh;
+            std::uint32_t       lod; // Level of detail of the mesh to draw.
+            Matrix4             model; // Includes the mesh's dequantization.
+            Material            material;
+            Box                 bounds; // In world space, which those culled on the GPU are tested with.
+        };
+
+    private:
+        // Sorted by key, then by mesh, which tells apart the arena meshes whose key holds the VAO they share.
+        struct Entry
+        {
+            std::uint64_t key;
+            std::uint32_t mesh, item;
+        };
+
+        // Entries [begin, end) sharing their state, with their instances from first_instance on unless not instanced.
+        struct Run
+        {
+            std::uint32_t begin, end;
+            std::size_t   first_instance;
+        };
+
+        std::vector<Item>  items_;
+        std::vector<Entry> entries_;
+        std::vector<Run>   runs_;
+        std::size_t        draw_count_ = 0;
+
+        std::vector<GpuCulling::Object> culled_objects_; // Scratch space of the submit.
+
+    public:
+        void clear();
+        void push(Item const& item);
+
+        // Draws the items in order of their keys, leaving the default program in use. Items the culling is given for
+        // are only drawn if they are in its frustum.
+        void submit(Pipeline const& default_shaders, FrameRing& ring, OptPtr<GpuCulling> culling = nullptr);
+
+        [[nodiscard]] std::size_t size() const;
+
+        // Draw calls the last submit issued, at most one per item.
+        [[nodiscard]] std::size_t drawCount() const;
+
+        // From the most significant bits down: whether the item is translucent, then its program, texture, VAO and
+        // level of detail.
+        [[nodiscard]] static std::uint64_t keyOf(Item const& item);
+        // Where the mesh's indices start in the arena, or 0 for meshes outside it and translucent items, which must
+        // keep their order.
+        [[nodiscard]] static std::uint32_t meshKeyOf(Item const& item);
+
+        // Whether an item drawn with them is left to the culling given to submit, which only takes the items of
+        // opaque multi-draws, since compacting their commands loses the order blending depends on.
+        [[nodiscard]] static bool culledOnGpu(Pipeline const& pipeline, Mesh const& mesh, Material const& material);
+    };
+}
@@ -14,18 +14,28 @@ namespace render
           shaders_ {std::move(builder.shaders)},
           textures_ {std::move(builder.textures)},
           filters_ {std::move(builder.filters)},
-          root_ {std::move(builder.root)},
+          occluders_ {std::move(builder.occluders)},
+          graph_ {std::move(builder.graph)},
           default_shader_ {builder.default_shader},
+          assets_ {std::move(builder.assets)},
+          gpu_culling_ {std::move(builder.gpu_culling)},
           light_position {builder.light_position},
           camera_controller {*std::move(builder.camera)}
-    { }
+    {
+        graph_->compact();
+    }
 
-    Scene Scene::setup([[maybe_unused]] engine::GlInit gl_init, config::Settings const& settings)
+    Scene Scene::setup(
+        [[maybe_unused]] engine::GlInit gl_init,
+        engine::JobSystem&              jobs,
+        config::Settings const&         settings
+    )
     {
         Builder b;
+        b.jobs = &jobs;
         config::hooks::setupScene(b, settings);
         assert(b.camera.has_value());
-        assert(b.default_shader != nullptr);
+        assert(b.shaders.contains(b.default_shader));
         return b;
     }
 
@@ -33,18 +43,33 @@ namespace render
     {
         config::hooks::beforeRender(*this, engine, elapsed_sec);
 
+        ring_.beginFrame();
         camera_controller.update(engine.windowSize(), elapsed_sec);
-        scene_block_.update(camera_controller.camera.position(), light_position);
-        root_->update(elapsed_sec);
-        glUseProgram(default_shader_->programId());
-        root_->draw(Matrix4::identity(), default_shader_, *this);
+        camera_controller.camera.bind(ring_);
+        scene_block_.update(ring_, camera_controller.camera.position(), light_position);
+        graph_->update(elapsed_sec);
+        graph_->updateBounds(*this);
+        graph_->buildBatches(*this);
+        auto const& default_shader  = shaders_[default_shader_];
+        auto const  view_projection = camera_controller.camera.viewProjection();
+        occlusion_.clear(view_projection);
+        graph_->addOccluders(occlusion_, *this);
+        occlusion_.rasterize(engine.jobs);
+        queue_.clear();
+        auto const  screen          = ScreenSize {view_projection, static_cast<float>(engine.windowSize().height)};
+        auto const  frustum         = Frustum {view_projection};
+        auto const  culling         = gpu_culling_ ? &*gpu_culling_ : nullptr;
+        if (culling != nullptr) culling->setFrustum(frustum);
+        graph_->collect(queue_, default_shader, *this, frustum, screen, occlusion_, culling != nullptr);
+        queue_.submit(default_shader, ring_, culling);
+        ring_.endFrame();
 
         config::hooks::afterRender(*this, engine, elapsed_sec);
     }
 
     void Scene::animate()
     {
-        root_->animate();
+        graph_->animate();
     }
 
     void Scene::resizeFilters(callback::WindowSize const size)
@@ -52,5 +77,16 @@ namespace render
         for (auto& filter : filters_) { filter.resize(size); }
     }
 
-    Texture const& Scene::defaultTexture() const { return default_texture_; }
+    SlotMap<Mesh> const&         Scene::meshes() const { return meshes_; }
+    SlotMap<Pipeline> const&     Scene::pipelines() const { return shaders_; }
+    SlotMap<Texture> const&      Scene::textures() const { return textures_; }
+    SlotMap<OccluderMesh> const& Scene::occluders() const { return occluders_; }
+    Texture const&               Scene::defaultTexture() const { return default_texture_; }
+
+    Scene::FrameStats Scene::frameStats() const
+    {
+        return {queue_.drawCount(), occlusion_.triangleCount(), ring_.peakUsage(), ring_.segmentSize()};
+    }
+
+    SceneGraph::Stats Scene::graphStats() const { return graph_->stats(); }
 }
@@ -3,12 +3,20 @@
 #include <deque>
 
 #include "Camera.h"
+#include "FrameRing.h"
 #include "Mesh.h"
 #include "Object.h"
+#include "Occlusion.h"
+#include "RenderQueue.h"
+#include "SceneGraph.h"
 #include "Filter.h"
+#include "GpuCulling.h"
 #include "SceneBlock.h"
 #include "Shader.h"
+#include "SlotMap.h"
+#include "../Engine/AssetPack.h"
 #include "../Engine/GlInit.h"
+#include "../Engine/JobSystem.h"
 
 namespace render
 {
@@ -17,44 +25,79 @@ namespace render
     public:
         friend class engine::Engine;
 
+        // Bytes of per frame data the ring starts out with room for, a few thousand objects' worth.
+        static constexpr std::size_t InitialRingSize = std::size_t {1} << 20;
+
         struct Builder
         {
-            std::deque<Mesh>     meshes;
-            std::deque<Pipeline> shaders;
-            std::deque<Filter>   filters;
-            std::deque<Texture>  textures;
+            SlotMap<Mesh>      meshes;
+            SlotMap<Pipeline>  shaders;
+            std::deque<Filter> filters;
+            SlotMap<Texture>   textures;
+
+            SlotMap<OccluderMesh> occluders;
 
             Vector3 light_position;
 
             std::optional<CameraController> camera;
-            std::unique_ptr<Object>         root = std::make_unique<Object>(nullptr);
+            std::unique_ptr<SceneGraph>     graph = std::make_unique<SceneGraph>();
+
+            PipelineHandle default_shader;
+
+            std::optional<engine::AssetPack> assets;
+
+            std::optional<GpuCulling> gpu_culling; // Culls on the CPU when left empty.
 
-            Ptr<Pipeline const> default_shader;
+            Ptr<engine::JobSystem> jobs;
+        };
+
+        struct FrameStats
+        {
+            std::size_t draws;              // Draw calls the render queue issued.
+            std::size_t occluder_triangles; // Triangles rasterized into the occlusion buffer.
+            std::size_t ring_peak;          // Most bytes of per frame data any frame has used.
+            std::size_t ring_segment;       // Bytes each frame has room for before the ring grows.
         };
 
     private:
-        std::deque<Mesh>     meshes_;
-        std::deque<Pipeline> shaders_;
-        std::deque<Texture>  textures_;
-        std::deque<Filter>   filters_;
+        SlotMap<Mesh>      meshes_;
+        SlotMap<Pipeline>  shaders_;
+        SlotMap<Texture>   textures_;
+        std::deque<Filter> filters_;
 
-        std::unique_ptr<Object> root_;
-        Ptr<Pipeline const>     default_shader_;
+        SlotMap<OccluderMesh> occluders_;
+
+        std::unique_ptr<SceneGraph>      graph_;
+        RenderQueue                      queue_;
+        OcclusionBuffer                  occlusion_;
+        PipelineHandle                   default_shader_;
+        std::optional<engine::AssetPack> assets_;
+        std::optional<GpuCulling>        gpu_culling_;
         Texture                 default_texture_ = Texture::white();
         SceneBlock              scene_block_     = SceneBlock(Pipeline::Scene);
+        FrameRing               ring_            = FrameRing(InitialRingSize); // Grows with the scene.
     public:
         Vector3          light_position;
         CameraController camera_controller;
     private:
         Scene(Builder&& builder);
     public:
-        static Scene setup(engine::GlInit gl_init, config::Settings const& settings);
+        static Scene setup(engine::GlInit gl_init, engine::JobSystem& jobs, config::Settings const& settings);
 
         void render(engine::Engine&, double elapsed_sec);
         void animate();
         void resizeFilters(callback::WindowSize size);
 
-        [[nodiscard]] Texture const& defaultTexture() const;
+        [[nodiscard]] SlotMap<Mesh> const&         meshes() const;
+        [[nodiscard]] SlotMap<Pipeline> const&     pipelines() const;
+        [[nodiscard]] SlotMap<Texture> const&      textures() const;
+        [[nodiscard]] SlotMap<OccluderMesh> const& occluders() const;
+        [[nodiscard]] Texture const&               defaultTexture() const;
+
+        // Of the last frame rendered.
+        [[nodiscard]] FrameStats frameStats() const;
+        // Of the graph as it is now.
+        [[nodiscard]] SceneGraph::Stats graphStats() const;
     };
 }
 
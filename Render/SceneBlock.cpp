@@ -4,46 +4,24 @@
 
 namespace render
 {
-    SceneBlock::SceneBlock(GLuint const bind_id)
+    namespace
     {
-        glGenBuffers(1, &scene_block_id_);
-        glBindBuffer(GL_UNIFORM_BUFFER, scene_block_id_);
+        // Contents of the std140 SceneGlobals block, which rounds each vec3 up to 16 bytes.
+        struct Block
         {
-            glBufferData(GL_UNIFORM_BUFFER, sizeof(Vector3) * 2, nullptr, GL_STREAM_DRAW);
-            glBindBufferBase(GL_UNIFORM_BUFFER, bind_id, scene_block_id_);
-        }
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            Vector3 eye;
+            float   padding0;
+            Vector3 light;
+            float   padding1;
+        };
     }
 
-    SceneBlock::SceneBlock(SceneBlock&& other) noexcept
-        : scene_block_id_ {std::exchange(other.scene_block_id_, 0)}
+    SceneBlock::SceneBlock(GLuint const bind_id)
+        : bind_id_ {bind_id}
     {}
 
-    SceneBlock& SceneBlock::operator=(SceneBlock&& other) noexcept
-    {
-        if (this != &other)
-        {
-            scene_block_id_ = std::exchange(other.scene_block_id_, 0);
-        }
-        return *this;
-    }
-
-    SceneBlock::~SceneBlock()
+    void SceneBlock::update(FrameRing& ring, Vector3 const camera_position, Vector3 const light_position) const
     {
-        if (scene_block_id_ != 0)
-        {
-            glDeleteBuffers(1, &scene_block_id_);
-            glBindBuffer(GL_UNIFORM_BUFFER, 0);
-        }
-    }
-
-    void SceneBlock::update(Vector3 camera_position, Vector3 light_position)
-    {
-        glBindBuffer(GL_UNIFORM_BUFFER, scene_block_id_);
-        {
-            glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Vector3), &camera_position);
-            glBufferSubData(GL_UNIFORM_BUFFER, sizeof(Vector3), sizeof(Vector3), &light_position);
-        }
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        ring.bindUniform(bind_id_, Block {camera_position, 0, light_position, 0});
     }
 }
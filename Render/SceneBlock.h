@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include "FrameRing.h"
 #include "../Math/Vector.h"
 #include "GL/glew.h"
 
@@ -7,19 +8,11 @@ namespace render
 {
     class SceneBlock
     {
-        GLuint scene_block_id_;
+        GLuint bind_id_;
     public:
         explicit SceneBlock(GLuint bind_id);
 
-        SceneBlock(SceneBlock const& other)            = delete;
-        SceneBlock& operator=(SceneBlock const& other) = delete;
-
-        SceneBlock(SceneBlock&& other) noexcept;
-
-        SceneBlock& operator=(SceneBlock&& other) noexcept;
-
-        ~SceneBlock();
-
-        void update(Vector3 camera_position, Vector3 light_position);
+        // Streams the block into the ring, for the draws of this frame.
+        void update(FrameRing& ring, Vector3 camera_position, Vector3 light_position) const;
     };
 }
@@ -0,0 +1,634 @@
+﻿#include "SceneGraph.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Scene.h"
+
+namespace render
+{
+    namespace
+    {
+        constexpr float MinPixelSize  = 1;     // Diameter on screen below which objects and subtrees are dropped.
+        constexpr float MaxPixelError = 1;     // Distance on screen a level of detail may be off from the full mesh.
+        constexpr float LodHysteresis = 0.25f; // Share of the error a coarser level must be below to switch to it.
+
+        // Coarsest level whose error on screen is below the limit, starting from the one drawn last. Refining happens
+        // as soon as the error exceeds the limit, coarsening only once the next level is well below it.
+        std::uint8_t selectLod(Mesh const& mesh, std::size_t level, float const radius)
+        {
+            level = std::min(level, mesh.lodCount() - 1);
+            while (level > 0 && mesh.lod(level).error * radius > MaxPixelError) level--;
+            while (level + 1 < mesh.lodCount()
+                   && mesh.lod(level + 1).error * radius <= MaxPixelError * (1 - LodHysteresis))
+                level++;
+            return static_cast<std::uint8_t>(level);
+        }
+
+        // Appends the part to the merged mesh, moved by the matrix and with every vertex taking the color. Parts
+        // without an attribute that others have get zeros for it.
+        void append(IndexedMesh& merged, IndexedMesh const& part, Matrix4 const& matrix, Vector4 const color)
+        {
+            auto const base = merged.positions.size();
+            merged.has_textures |= part.has_textures;
+            merged.has_normals |= part.has_normals;
+            merged.has_colors = true;
+            if (merged.has_textures) merged.tex_coords.resize(base, Vector2::filled(0));
+            if (merged.has_normals) merged.normals.resize(base, Vector3::filled(0));
+
+            auto const m = [&](std::size_t const row, std::size_t const column) { return matrix[row * 4 + column]; };
+            auto const normal_matrix = Matrix3 {
+                {m(0, 0), m(0, 1), m(0, 2), m(1, 0), m(1, 1), m(1, 2), m(2, 0), m(2, 1), m(2, 2)}
+            }.inverted().transposed();
+
+            for (std::size_t i = 0; i < part.positions.size(); i++)
+            {
+                auto const [x, y, z] = part.positions[i];
+                merged.positions.push_back({
+                    m(0, 0) * x + m(0, 1) * y + m(0, 2) * z + m(0, 3),
+                    m(1, 0) * x + m(1, 1) * y + m(1, 2) * z + m(1, 3),
+                    m(2, 0) * x + m(2, 1) * y + m(2, 2) * z + m(2, 3)
+                });
+
+                if (merged.has_textures)
+                    merged.tex_coords.push_back(part.has_textures ? part.tex_coords[i] : Vector2::filled(0));
+                if (merged.has_normals)
+                {
+                    auto const normal = part.has_normals ? normal_matrix * part.normals[i] : Vector3::filled(0);
+                    auto const length = normal.magnitude();
+                    merged.normals.push_back(length > 0 ? normal * (1 / length) : normal);
+                }
+
+                auto const [r, g, b, a] = part.has_colors ? part.colors[i] : Vector4::filled(1);
+                merged.colors.push_back({r * color.x, g * color.y, b * color.z, a * color.w});
+            }
+            for (auto const index : part.indices) { merged.indices.push_back(static_cast<GLuint>(base + index)); }
+        }
+    }
+
+    SceneGraph::SceneGraph()
+        : peak_ {0}
+    {
+        emplace({}, {}, Vector4::filled(1.0f), {}, {});
+    }
+
+    Object SceneGraph::root() { return {*this, Root}; }
+
+    ObjectHandle SceneGraph::emplace(
+        ObjectHandle const   parent,
+        MeshHandle const     mesh,
+        Vector4 const        color,
+        PipelineHandle const shaders,
+        TextureHandle const  texture
+    )
+    {
+        // Only the root, which is added first, has no parent.
+        if (!parents_.empty() && !alive(parent))
+            throw std::invalid_argument("Cannot add an object under a removed one.");
+
+        auto const parent_index = parents_.empty() ? NoObject : locate(parent);
+        if (parent_index != NoObject) edited(parent_index);
+
+        auto const index  = takeSlot(parent_index);
+        auto const handle = indices_.emplace(index);
+
+        parents_[index]        = parent_index;
+        flags_[index]          = Alive | Dirty;
+        transforms_[index]     = {};
+        local_matrices_[index] = Matrix4::identity();
+        world_matrices_[index] = Matrix4::identity();
+        bounds_[index]         = Box::empty();
+        subtree_bounds_[index] = Box::empty();
+        draw_states_[index]    = {mesh, shaders, texture};
+        materials_[index]      = {color};
+        occluders_[index]      = {};
+        lod_levels_[index]     = 0;
+        links_[index]          = {NoObject, NoObject, NoObject, NoObject};
+        handles_[index]        = handle;
+        animations_[index].reset();
+        batches_[index].reset();
+        peak_ = std::max(peak_, indices_.size());
+
+        if (parent_index != NoObject)
+        {
+            auto& siblings = links_[parent_index];
+            if (siblings.last_child == NoObject) siblings.first_child = index;
+            else links_[siblings.last_child].next = index;
+            links_[index].previous = siblings.last_child;
+            siblings.last_child    = index;
+        }
+        return handle;
+    }
+
+    void SceneGraph::remove(ObjectHandle const handle)
+    {
+        if (handle == Root) throw std::invalid_argument("Cannot remove the root of a scene.");
+        if (!alive(handle)) return;
+
+        auto const object = locate(handle);
+        edited(parents_[object]);
+
+        auto const previous = links_[object].previous;
+        auto const next     = links_[object].next;
+        auto&      siblings = links_[parents_[object]];
+        if (previous == NoObject) siblings.first_child = next;
+        else links_[previous].next = next;
+        if (next == NoObject) siblings.last_child = previous;
+        else links_[next].previous = previous;
+
+        auto const first_freed   = free_.size();
+        auto       had_animation = false;
+        auto       had_occluder  = false;
+        auto       had_batch     = false;
+        for (pending_.assign(1, object); !pending_.empty();)
+        {
+            auto const current = pending_.back();
+            pending_.pop_back();
+            for (auto child = links_[current].first_child; child != NoObject; child = links_[child].next)
+                pending_.push_back(child);
+
+            had_animation |= animations_[current].has_value();
+            had_occluder |= static_cast<bool>(occluders_[current]);
+            had_batch |= static_cast<bool>(flags_[current] & Frozen);
+            flags_[current]       = 0;
+            draw_states_[current] = {};
+            occluders_[current]   = {};
+            animations_[current].reset();
+            batches_[current].reset();
+            links_[current] = {NoObject, NoObject, NoObject, NoObject};
+            indices_.erase(handles_[current]);
+            handles_[current] = {};
+            free_.push_back(current);
+        }
+        // Lowest last, so a similar subtree added next takes the parents' slots first and fits the children after.
+        std::sort(free_.begin() + first_freed, free_.end(), std::greater<> {});
+        bounds_dirty_ = true;
+
+        auto const removed = [&](Index const index) { return !(flags_[index] & Alive); };
+        if (had_animation)
+            animated_.erase(std::remove_if(animated_.begin(), animated_.end(), removed), animated_.end());
+        if (had_occluder)
+            occluding_.erase(std::remove_if(occluding_.begin(), occluding_.end(), removed), occluding_.end());
+        if (had_batch) frozen_.erase(std::remove_if(frozen_.begin(), frozen_.end(), removed), frozen_.end());
+    }
+
+    void SceneGraph::clear()
+    {
+        if (flags_[0] & Frozen) thaw(0);
+
+        for (auto index = Index {1}; index < handles_.size(); index++)
+            if (flags_[index] & Alive) indices_.erase(handles_[index]);
+
+        auto const keep = [](auto& elements) { elements.erase(elements.begin() + 1, elements.end()); };
+        keep(parents_);
+        keep(flags_);
+        keep(transforms_);
+        keep(local_matrices_);
+        keep(world_matrices_);
+        keep(bounds_);
+        keep(subtree_bounds_);
+        keep(draw_states_);
+        keep(materials_);
+        keep(occluders_);
+        keep(lod_levels_);
+        keep(links_);
+        keep(animations_);
+        keep(batches_);
+        keep(handles_);
+
+        links_[0] = {NoObject, NoObject, NoObject, NoObject};
+        animated_.assign(animations_[0] ? 1 : 0, 0);
+        occluding_.assign(occluders_[0] ? 1 : 0, 0);
+        frozen_.clear();
+        free_.clear();
+        bounds_dirty_ = true;
+    }
+
+    void SceneGraph::reserve(std::size_t const capacity)
+    {
+        parents_.reserve(capacity);
+        flags_.reserve(capacity);
+        transforms_.reserve(capacity);
+        local_matrices_.reserve(capacity);
+        world_matrices_.reserve(capacity);
+        bounds_.reserve(capacity);
+        subtree_bounds_.reserve(capacity);
+        draw_states_.reserve(capacity);
+        materials_.reserve(capacity);
+        occluders_.reserve(capacity);
+        lod_levels_.reserve(capacity);
+        links_.reserve(capacity);
+        animations_.reserve(capacity);
+        batches_.reserve(capacity);
+        handles_.reserve(capacity);
+    }
+
+    void SceneGraph::compact()
+    {
+        // Breadth first, so every parent still comes before its children and the children of each are contiguous.
+        std::vector<Index> order {0};
+        order.reserve(indices_.size());
+        for (std::size_t i = 0; i < order.size(); i++)
+            for (auto child = links_[order[i]].first_child; child != NoObject; child = links_[child].next)
+                order.push_back(child);
+
+        std::vector<Index> moved_to(parents_.size(), NoObject);
+        for (std::size_t i = 0; i < order.size(); i++) { moved_to[order[i]] = static_cast<Index>(i); }
+        auto const remap = [&](Index const index) { return index == NoObject ? NoObject : moved_to[index]; };
+
+        auto const permute = [&](auto& elements)
+        {
+            std::remove_reference_t<decltype(elements)> permuted;
+            permuted.reserve(order.size());
+            for (auto const index : order) { permuted.push_back(std::move(elements[index])); }
+            elements = std::move(permuted);
+        };
+        permute(parents_);
+        permute(flags_);
+        permute(transforms_);
+        permute(local_matrices_);
+        permute(world_matrices_);
+        permute(bounds_);
+        permute(subtree_bounds_);
+        permute(draw_states_);
+        permute(materials_);
+        permute(occluders_);
+        permute(lod_levels_);
+        permute(links_);
+        permute(animations_);
+        permute(batches_);
+        permute(handles_);
+
+        for (auto& parent : parents_) { parent = remap(parent); }
+        for (auto& [first_child, last_child, previous, next] : links_)
+        {
+            first_child = remap(first_child);
+            last_child  = remap(last_child);
+            previous    = remap(previous);
+            next        = remap(next);
+        }
+        for (auto& index : animated_) { index = moved_to[index]; }
+        for (auto& index : occluding_) { index = moved_to[index]; }
+        for (auto& index : frozen_) { index = moved_to[index]; }
+        for (Index index = 0; index < handles_.size(); index++) { *indices_.get(handles_[index]) = index; }
+        free_.clear();
+    }
+
+    void SceneGraph::animate()
+    {
+        for (auto const index : animated_)
+        {
+            auto& animation = *animations_[index];
+            if (animation.active()) { animation.reverse(); }
+            else { animation.activate(); }
+        }
+    }
+
+    void SceneGraph::update(double const elapsed_sec)
+    {
+        if (free_.size() * 2 > parents_.size()) compact();
+
+        for (auto const index : animated_)
+        {
+            if (auto& animation = *animations_[index]; animation.active())
+            {
+                transforms_[index] = animation.advance(elapsed_sec);
+                flags_[index] |= Dirty;
+            }
+        }
+
+        for (Index index = 0; index < parents_.size(); index++)
+        {
+            auto& flags = flags_[index];
+            if (!(flags & Alive)) continue;
+
+            auto const parent = parents_[index];
+            if (flags & Dirty) local_matrices_[index] = transforms_[index].toMatrix();
+
+            auto const moved = (flags & Dirty) || (parent != NoObject && (flags_[parent] & Moved));
+            if (moved)
+            {
+                world_matrices_[index] = parent != NoObject
+                                             ? world_matrices_[parent] * local_matrices_[index]
+                                             : local_matrices_[index];
+            }
+            flags = (flags & (Frozen | Merged)) | (moved ? Alive | Moved : Alive);
+            bounds_dirty_ |= moved;
+        }
+    }
+
+    void SceneGraph::updateBounds(Scene const& scene)
+    {
+        if (!bounds_dirty_) return;
+        bounds_dirty_ = false;
+
+        for (Index index = 0; index < parents_.size(); index++)
+        {
+            auto const mesh = flags_[index] & Alive ? scene.meshes().get(draw_states_[index].mesh) : nullptr;
+            auto const box  = mesh != nullptr ? mesh->bounds().transformed(world_matrices_[index]) : Box::empty();
+
+            bounds_[index]         = box;
+            subtree_bounds_[index] = box;
+        }
+
+        // Children come after their parents, so going backwards every subtree is complete before it is merged upwards.
+        for (auto index = static_cast<Index>(parents_.size()); index-- > 1;)
+        {
+            if (!(flags_[index] & Alive)) continue;
+
+            auto& parent = subtree_bounds_[parents_[index]];
+            parent       = parent.merged(subtree_bounds_[index]);
+        }
+    }
+
+    void SceneGraph::buildBatches(Scene const& scene)
+    {
+        if (!batches_dirty_) return;
+        batches_dirty_ = false;
+
+        for (auto const index : frozen_)
+            if (!batches_[index]) batches_[index] = merge(index, scene);
+    }
+
+    void SceneGraph::addOccluders(OcclusionBuffer& occlusion, Scene const& scene) const
+    {
+        for (auto const index : occluding_)
+        {
+            // Whatever hides nothing when drawn must not hide anything here either.
+            auto const occluder = scene.occluders().get(occluders_[index]);
+            auto const mesh     = scene.meshes().get(draw_states_[index].mesh);
+            if (occluder == nullptr || mesh == nullptr || materials_[index].color.w < 1) continue;
+
+            occlusion.add(*occluder, world_matrices_[index]);
+        }
+    }
+
+    void SceneGraph::collect(
+        RenderQueue&           queue,
+        Pipeline const&        default_shaders,
+        Scene const&           scene,
+        Frustum const&         frustum,
+        ScreenSize const&      screen,
+        OcclusionBuffer const& occlusion,
+        bool const             gpu_culling
+    )
+    {
+        using Test = Frustum::Test;
+
+        effective_shaders_.resize(parents_.size());
+        visibility_.resize(parents_.size());
+
+        for (Index index = 0; index < parents_.size(); index++)
+        {
+            if (!(flags_[index] & Alive)) continue;
+
+            // A subtree entirely outside or inside the frustum decides for everything below it without more tests.
+            // With culling on the GPU, leaves are left to the test of their own bounds, which it may take over.
+            auto const parent     = parents_[index];
+            auto const above      = parent != NoObject ? visibility_[parent] : Test::Intersects;
+            auto const leaf       = links_[index].first_child == NoObject;
+            auto const deferred   = gpu_culling && leaf && !batches_[index];
+            auto       visibility = above;
+            if (above == Test::Intersects && !deferred) visibility = frustum.test(subtree_bounds_[index]);
+
+            // So are subtrees too small to cover a pixel. A leaf's own bounds are those of its subtree.
+            auto const subtree_radius = visibility != Test::Outside ? screen.radius(subtree_bounds_[index]) : 0.f;
+            if (subtree_radius * 2 < MinPixelSize) visibility = Test::Outside;
+
+            // Occlusion is tested for every subtree the frustum lets through, except those of the occluders, which
+            // would otherwise hide themselves.
+            auto const occludes = static_cast<bool>(occluders_[index]);
+            if (visibility != Test::Outside && !occludes && occlusion.occluded(subtree_bounds_[index]))
+                visibility = Test::Outside;
+            visibility_[index] = visibility;
+            if (visibility == Test::Outside) continue;
+
+            // Objects without shaders of their own use their parent's, which were resolved earlier in the pass.
+            auto const& [mesh_handle, shaders_handle, texture_handle] = draw_states_[index];
+
+            auto const inherited = parent != NoObject ? effective_shaders_[parent] : &default_shaders;
+            auto const own       = scene.pipelines().get(shaders_handle);
+            auto const shaders   = own != nullptr ? own : inherited;
+            effective_shaders_[index] = shaders;
+
+            // A frozen object draws the merged meshes of its subtree in place of the objects merged into them.
+            if (auto const& batch = batches_[index])
+            {
+                for (auto const& [mesh, draw_shaders, draw_texture, draw_material] : batch->draws)
+                {
+                    auto const merged_shaders = scene.pipelines().get(draw_shaders);
+                    auto const merged_texture = scene.textures().get(draw_texture);
+                    queue.push({
+                        merged_shaders != nullptr ? merged_shaders : inherited,
+                        (merged_texture != nullptr ? *merged_texture : scene.defaultTexture()).texId(),
+                        &mesh,
+                        0,
+                        world_matrices_[index] * mesh.dequantization(),
+                        draw_material,
+                        subtree_bounds_[index]
+                    });
+                }
+                if (batch->complete) visibility_[index] = Test::Outside;
+            }
+            if (flags_[index] & Merged) continue;
+
+            auto const  mesh     = scene.meshes().get(mesh_handle);
+            auto const& material = materials_[index];
+            if (mesh == nullptr || material.color.w == 0) continue;
+            auto const gpu_culled = gpu_culling && RenderQueue::culledOnGpu(*shaders, *mesh, material);
+            if (visibility == Test::Intersects && !gpu_culled && frustum.test(bounds_[index]) == Test::Outside)
+                continue;
+            if (!occludes && !leaf && occlusion.occluded(bounds_[index])) continue;
+
+            auto const radius = leaf ? subtree_radius : screen.radius(bounds_[index]);
+            if (radius * 2 < MinPixelSize) continue;
+            lod_levels_[index] = selectLod(*mesh, lod_levels_[index], radius);
+
+            auto const texture = scene.textures().get(texture_handle);
+            queue.push({
+                shaders,
+                (texture != nullptr ? *texture : scene.defaultTexture()).texId(),
+                mesh,
+                lod_levels_[index],
+                world_matrices_[index] * mesh->dequantization(),
+                material,
+                bounds_[index]
+            });
+        }
+    }
+
+    bool SceneGraph::alive(ObjectHandle const object) const { return indices_.contains(object); }
+
+    std::size_t SceneGraph::size() const { return indices_.size(); }
+
+    SceneGraph::Stats SceneGraph::stats() const
+    {
+        auto const capacity = parents_.size();
+        return {indices_.size(), peak_, capacity, static_cast<float>(free_.size()) / static_cast<float>(capacity)};
+    }
+
+    SceneGraph::Index SceneGraph::takeSlot(Index const parent)
+    {
+        if (!free_.empty() && parent != NoObject && free_.back() > parent)
+        {
+            auto const index = free_.back();
+            free_.pop_back();
+            return index;
+        }
+
+        auto const index = static_cast<Index>(parents_.size());
+        parents_.emplace_back();
+        flags_.emplace_back();
+        transforms_.emplace_back();
+        local_matrices_.emplace_back();
+        world_matrices_.emplace_back();
+        bounds_.emplace_back();
+        subtree_bounds_.emplace_back();
+        draw_states_.emplace_back();
+        materials_.emplace_back();
+        occluders_.emplace_back();
+        lod_levels_.emplace_back();
+        links_.emplace_back();
+        animations_.emplace_back();
+        batches_.emplace_back();
+        handles_.emplace_back();
+        return index;
+    }
+
+    SceneGraph::Index SceneGraph::locate(ObjectHandle const object) const
+    {
+        if (auto const index = indices_.get(object)) return *index;
+        throw std::invalid_argument("Cannot use an object after it was removed.");
+    }
+
+    std::optional<Object> SceneGraph::objectAt(Index const index)
+    {
+        if (index == NoObject) return std::nullopt;
+        return Object {*this, handles_[index]};
+    }
+
+    void SceneGraph::freeze(Index const object)
+    {
+        if (flags_[object] & Frozen) return;
+
+        // Subtrees frozen above or below this one would share objects with it, so both kinds are thawed.
+        edited(object, true);
+        for (auto i = frozen_.size(); i-- > 0;)
+        {
+            auto const other = frozen_[i];
+            for (auto above = parents_[other]; above != NoObject; above = parents_[above])
+            {
+                if (above != object) continue;
+                thaw(other);
+                break;
+            }
+        }
+
+        flags_[object] |= Frozen;
+        frozen_.push_back(object);
+        batches_dirty_ = true;
+    }
+
+    void SceneGraph::thaw(Index const object)
+    {
+        flags_[object] &= ~Frozen;
+        batches_[object].reset();
+        frozen_.erase(std::find(frozen_.begin(), frozen_.end(), object));
+
+        for (std::vector<Index> below {object}; !below.empty();)
+        {
+            auto const current = below.back();
+            below.pop_back();
+            flags_[current] &= ~Merged;
+            for (auto child = links_[current].first_child; child != NoObject; child = links_[child].next)
+                below.push_back(child);
+        }
+    }
+
+    void SceneGraph::edited(Index const object, bool const placement_only)
+    {
+        if (frozen_.empty()) return;
+
+        auto current = placement_only ? parents_[object] : object;
+        for (; current != NoObject; current = parents_[current])
+            if (flags_[current] & Frozen) thaw(current);
+    }
+
+    SceneGraph::StaticBatch SceneGraph::merge(Index const object, Scene const& scene)
+    {
+        struct Group
+        {
+            PipelineHandle   shaders;
+            TextureHandle    texture;
+            Material         material;
+            config::Geometry geometry; // Of the first mesh merged into the group.
+            IndexedMesh      mesh;
+        };
+
+        struct Visit
+        {
+            Index          index;
+            Matrix4        matrix;  // From the object's model space to the frozen one's.
+            PipelineHandle shaders; // Inherited from above, null while the frozen object has none of its own.
+        };
+
+        std::vector<Group> groups;
+        std::vector<Visit> pending {{object, Matrix4::identity(), draw_states_[object].shaders}};
+        auto               complete = true;
+        while (!pending.empty())
+        {
+            auto const [index, matrix, inherited] = pending.back();
+            pending.pop_back();
+
+            auto const& [mesh_handle, own_shaders, texture] = draw_states_[index];
+            auto const shaders = own_shaders ? own_shaders : inherited;
+            for (auto child = links_[index].first_child; child != NoObject; child = links_[child].next)
+            {
+                // Animated objects move within the subtree, so they are drawn on their own with everything below.
+                if (animations_[child]) complete = false;
+                else pending.push_back({child, matrix * transforms_[child].toMatrix(), shaders});
+            }
+
+            // Translucent objects are drawn in order with everything else, invisible ones not at all.
+            auto const  mesh     = scene.meshes().get(mesh_handle);
+            auto const& material = materials_[index];
+            if (mesh == nullptr || material.color.w < 1)
+            {
+                complete &= mesh == nullptr || material.color.w == 0;
+                continue;
+            }
+
+            auto group = std::find_if(
+                groups.begin(),
+                groups.end(),
+                [&](Group const& candidate)
+                {
+                    auto const& other = candidate.material;
+                    return candidate.shaders == shaders && candidate.texture == texture
+                           && other.ambient_color == material.ambient_color
+                           && other.specular_color == material.specular_color && other.shininess == material.shininess;
+                }
+            );
+            if (group == groups.end())
+            {
+                auto const white = Material {
+                    Vector4::filled(1),
+                    material.ambient_color,
+                    material.specular_color,
+                    material.shininess
+                };
+                group = groups.insert(groups.end(), {shaders, texture, white, mesh->geometry(), {}});
+            }
+
+            append(group->mesh, mesh->read(), matrix, material.color);
+            flags_[index] |= Merged;
+        }
+
+        StaticBatch batch {{}, complete};
+        for (auto const& [shaders, texture, material, geometry, mesh] : groups)
+            batch.draws.push_back({Mesh {mesh, geometry}, shaders, texture, material});
+        return batch;
+    }
+}
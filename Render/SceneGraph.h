@@ -0,0 +1,187 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Bounds.h"
+#include "Object.h"
+#include "Occlusion.h"
+#include "RenderQueue.h"
+#include "SlotMap.h"
+
+namespace render
+{
+    class Scene;
+
+    // Objects stored as parallel arrays in topological order, every parent before its children, so that updating and
+    // collecting the draws are linear passes instead of a walk through heap allocated nodes. What each pass reads is
+    // kept apart from the rest: the update touches the parents, flags and transforms, the collection the bounds, draw
+    // states, materials and occluders, and only navigation and editing touch the links and animations.
+    //
+    // The arrays double as the pool the objects are allocated from. Removed objects leave holes that the passes skip
+    // and later objects fill, and once holes make up half of the arrays they are compacted breadth first, which also
+    // puts siblings next to each other. Objects are referred to from outside by generational handles, mapped to their
+    // position in the arrays, so neither reusing nor moving slots affects them.
+    //
+    // Subtrees that never change can be frozen, after which their meshes are merged into a few drawn in their place.
+    // The frozen object itself may still move, the rest of the subtree is thawed by the first edit.
+    class SceneGraph
+    {
+    public:
+        static constexpr ObjectHandle Root {0, 0};
+
+        struct Stats
+        {
+            std::size_t live;          // Objects in the graph, the root included.
+            std::size_t peak;          // Most objects the graph held at once.
+            std::size_t capacity;      // Slots in the arrays, empty ones included.
+            float       fragmentation; // Share of the slots left empty by removed objects.
+        };
+
+    private:
+        friend class Object;
+
+        using Index = std::uint32_t; // Position in the arrays.
+
+        static constexpr Index NoObject = ~Index {0};
+
+        enum Flags : std::uint8_t
+        {
+            Alive  = 1 << 0,
+            Dirty  = 1 << 1, // The transform changed since the last update.
+            Moved  = 1 << 2, // The world matrix changed during the last update.
+            Frozen = 1 << 3, // Draws its subtree's merged meshes, once they are built.
+            Merged = 1 << 4, // Drawn as part of a frozen object's merged meshes instead of on its own.
+        };
+
+        struct DrawState
+        {
+            MeshHandle     mesh;
+            PipelineHandle shaders;
+            TextureHandle  texture;
+        };
+
+        struct Links
+        {
+            Index first_child, last_child, previous, next;
+        };
+
+        // Meshes of a frozen subtree, merged in the frozen object's model space, one per pipeline, texture and material
+        // besides its color, which every vertex carries instead.
+        struct StaticBatch
+        {
+            struct Draw
+            {
+                Mesh           mesh;
+                PipelineHandle shaders; // Null when those the frozen object inherits are used.
+                TextureHandle  texture;
+                Material       material;
+            };
+
+            std::vector<Draw> draws;
+            bool              complete; // Whether every object of the subtree was merged, so the rest can be skipped.
+        };
+
+        std::vector<Index>        parents_;
+        std::vector<std::uint8_t> flags_;
+        std::vector<Transform>    transforms_;
+        std::vector<Matrix4>      local_matrices_;
+        std::vector<Matrix4>      world_matrices_;
+
+        std::vector<Box>       bounds_;         // World bounds of the object's own mesh.
+        std::vector<Box>       subtree_bounds_; // Of the object's mesh and those of everything below it.
+        std::vector<DrawState>      draw_states_;
+        std::vector<Material>       materials_;
+        std::vector<OccluderHandle> occluders_; // Stand in rasterized for the object, null for most.
+        std::vector<std::uint8_t>   lod_levels_; // Level of detail drawn last, which the next one is chosen from.
+
+        std::vector<Links>                      links_;
+        std::vector<std::optional<Animation>>   animations_;
+        std::vector<std::optional<StaticBatch>> batches_;   // Of the frozen objects, once built.
+        std::vector<Index>                      animated_;  // Objects with an animation, so the update skips the rest.
+        std::vector<Index>                      occluding_; // Objects with an occluder, likewise for the rasterization.
+        std::vector<Index>                      frozen_;    // Frozen objects, likewise for building and thawing.
+
+        SlotMap<Index, Object>    indices_; // Where each handle's object is.
+        std::vector<ObjectHandle> handles_; // The handle of each object.
+
+        std::vector<Index> free_; // Holes left by removed objects, most recent last.
+        std::size_t        peak_;
+        bool               bounds_dirty_  = true;  // Something moved, changed its mesh or was removed.
+        bool               batches_dirty_ = false; // Something was frozen since the batches were last built.
+
+        std::vector<Index> pending_; // Scratch space of the removal.
+
+        mutable std::vector<OptPtr<Pipeline const>> effective_shaders_; // Scratch space of the collection.
+        mutable std::vector<Frustum::Test>          visibility_;
+
+    public:
+        SceneGraph();
+
+        [[nodiscard]] Object root();
+
+        ObjectHandle emplace(
+            ObjectHandle   parent,
+            MeshHandle     mesh,
+            Vector4        color,
+            PipelineHandle shaders,
+            TextureHandle  texture
+        );
+
+        // Removes the object and everything below it, in time proportional to the size of the subtree.
+        void remove(ObjectHandle object);
+        // Removes every object but the root at once, keeping the memory for the objects added next.
+        void clear();
+
+        void reserve(std::size_t capacity);
+        // Moves the objects into breadth first order without holes. The update does so when enough holes pile up.
+        void compact();
+
+        void animate();
+        // Advances the animations and recomputes the world matrices of the subtrees whose transforms changed.
+        void update(double elapsed_sec);
+        // Recomputes the bounds of every object and subtree after an update that changed any, children first. Bounds of
+        // meshes removed from the scene are kept until then, which only makes them larger than needed.
+        void updateBounds(Scene const& scene);
+        // Merges the meshes of the subtrees frozen since the last call, reading them back from the GPU. Opaque objects
+        // with a mesh are merged unless they are animated or below an animated object, which are drawn on their own.
+        // Merged objects keep drawing the meshes they had when frozen, even once those are removed from the scene.
+        void buildBatches(Scene const& scene);
+        // Adds the occluders of the opaque objects that are drawn to the buffer, placed as of the last update.
+        void addOccluders(OcclusionBuffer& occlusion, Scene const& scene) const;
+        // Pushes a draw for every visible object whose bounds are in the frustum, not hidden behind the occluders and
+        // not too small to cover a pixel, rejecting or accepting whole subtrees with a single frustum test. Each object
+        // is drawn at the coarsest level of detail whose error stays below a pixel on screen, with some hysteresis so
+        // that objects near a threshold do not switch levels every frame. Objects whose mesh, shaders or texture were
+        // removed from the scene are drawn as if they had none. With gpu_culling, the objects the queue culls on the
+        // GPU are pushed without testing their own bounds against the frustum.
+        void collect(
+            RenderQueue&           queue,
+            Pipeline const&        default_shaders,
+            Scene const&           scene,
+            Frustum const&         frustum,
+            ScreenSize const&      screen,
+            OcclusionBuffer const& occlusion,
+            bool                   gpu_culling
+        );
+
+        [[nodiscard]] bool        alive(ObjectHandle object) const;
+        [[nodiscard]] std::size_t size() const; // Objects currently in the graph, the root included.
+        [[nodiscard]] Stats       stats() const;
+
+    private:
+        // The hole left most recently if it comes after the parent, so the order stays topological, or a new slot.
+        [[nodiscard]] Index takeSlot(Index parent);
+
+        [[nodiscard]] Index                 locate(ObjectHandle object) const;
+        [[nodiscard]] std::optional<Object> objectAt(Index index);
+
+        void freeze(Index object);
+        void thaw(Index object);
+        // Thaws the frozen subtrees that the edit of the object changes, which are those above it and, unless only
+        // its placement changes, its own.
+        void edited(Index object, bool placement_only = false);
+        [[nodiscard]] StaticBatch merge(Index object, Scene const& scene);
+    };
+}
@@ -4,6 +4,9 @@
 #include <fstream>
 #include <iostream>
 
+#include "GlState.h"
+#include "../Engine/AssetPack.h"
+
 namespace render
 {
     namespace
@@ -71,11 +74,45 @@ namespace render
         checkCompilation(shader_id_);
     }
 
-    Shader Shader::fromFile(Type const shader_type, std::filesystem::path const& shader_file)
+    Shader Shader::fromFile(
+        Type const                            shader_type,
+        std::filesystem::path const&          shader_file,
+        OptPtr<engine::AssetPack const> const assets
+    )
+    {
+        return fromSource(shader_type, shader_file, readSource(shader_file, assets));
+    }
+
+    std::string Shader::readSource(
+        std::filesystem::path const&          shader_file,
+        OptPtr<engine::AssetPack const> const assets
+    )
+    {
+        if (assets != nullptr)
+        {
+            if (auto const program = assets->shader(shader_file))
+                return std::string {*program};
+        }
+
+        try
+        {
+            return readShaderFile(shader_file);
+        }
+        catch (...)
+        {
+            std::cerr << "Error loading shader at " << absolute(shader_file) << '.' << std::endl;
+            throw;
+        }
+    }
+
+    Shader Shader::fromSource(
+        Type const                   shader_type,
+        std::filesystem::path const& shader_file,
+        std::string_view const       program
+    )
     {
         try
         {
-            auto const program = readShaderFile(shader_file);
             return Shader {shader_type, program};
         }
         catch (...)
@@ -119,7 +156,8 @@ namespace render
           ambient_id_ {std::exchange(other.ambient_id_, 0)},
           specular_id_ {std::exchange(other.specular_id_, 0)},
           shininess_id_ {std::exchange(other.shininess_id_, 0)},
-          is_filter_ {std::exchange(other.is_filter_, false)}
+          is_filter_ {std::exchange(other.is_filter_, false)},
+          instanced_ {std::move(other.instanced_)}
     {}
 
     Pipeline& Pipeline::operator=(Pipeline&& other) noexcept
@@ -134,6 +172,7 @@ namespace render
             specular_id_  = std::exchange(other.specular_id_, 0);
             shininess_id_ = std::exchange(other.shininess_id_, 0);
             is_filter_    = std::exchange(other.is_filter_, false);
+            instanced_    = std::move(other.instanced_);
         }
         return *this;
     }
@@ -142,6 +181,7 @@ namespace render
     {
         if (program_id_ != 0)
         {
+            GlState::current().forgetProgram(program_id_);
             glDeleteProgram(program_id_);
         }
     }
@@ -159,6 +199,14 @@ namespace render
         glBindAttribLocation(program_id_, Texture, "in_Texcoord");
         glBindAttribLocation(program_id_, Normal, "in_Normal");
 
+        glBindAttribLocation(program_id_, InstanceModel, "in_Model");
+        glBindAttribLocation(program_id_, InstanceColor, "in_Color");
+        glBindAttribLocation(program_id_, InstanceAmbient, "in_Ambient");
+        glBindAttribLocation(program_id_, InstanceSpecular, "in_Specular");
+        glBindAttribLocation(program_id_, InstanceShininess, "in_Shininess");
+
+        glBindAttribLocation(program_id_, VertexColor, "in_VertexColor");
+
         glLinkProgram(program_id_);
         checkLinkage(program_id_);
 
@@ -169,11 +217,12 @@ namespace render
         specular_id_  = glGetUniformLocation(program_id_, "Specular");
         shininess_id_ = glGetUniformLocation(program_id_, "Shininess");
 
+        // Programs that do not read a block, like compute ones, have none to bind.
         auto const camera_id = glGetUniformBlockIndex(program_id_, "CameraMatrices");
-        glUniformBlockBinding(program_id_, camera_id, Camera);
+        if (camera_id != GL_INVALID_INDEX) glUniformBlockBinding(program_id_, camera_id, Camera);
 
         auto const scene_id = glGetUniformBlockIndex(program_id_, "SceneGlobals");
-        glUniformBlockBinding(program_id_, scene_id, Scene);
+        if (scene_id != GL_INVALID_INDEX) glUniformBlockBinding(program_id_, scene_id, Scene);
 
         for (auto const& shader : shaders)
         {
@@ -190,6 +239,13 @@ namespace render
     GLuint Pipeline::ambientId() const { return ambient_id_; }
     GLuint Pipeline::specularId() const { return specular_id_; }
     GLuint Pipeline::shininessId() const { return shininess_id_; }
+
+    void Pipeline::setInstanced(Pipeline&& instanced)
+    {
+        instanced_ = std::make_unique<Pipeline>(std::move(instanced));
+    }
+
+    OptPtr<Pipeline const> Pipeline::instanced() const { return instanced_.get(); }
 }
 
 bool operator==(render::Pipeline const& lhs, render::Pipeline const& rhs)
@@ -1,11 +1,20 @@
 ﻿#pragma once
 
 #include <filesystem>
+#include <memory>
 #include <optional>
+#include <string>
 
 #include <GL/glew.h>
 
 #include "Shader.h"
+#include "SlotMap.h"
+#include "../Utils.h"
+
+namespace engine
+{
+    class AssetPack;
+}
 
 namespace render
 {
@@ -28,7 +37,18 @@ namespace render
 
     public:
         Shader(Type shader_type, std::string_view);
-        static Shader fromFile(Type shader_type, std::filesystem::path const& shader_file);
+        static Shader fromFile(
+            Type                            shader_type,
+            std::filesystem::path const&    shader_file,
+            OptPtr<engine::AssetPack const> assets = {}
+        );
+
+        // Split halves of fromFile, so the file can be read off the thread owning the GL context.
+        static std::string readSource(
+            std::filesystem::path const&    shader_file,
+            OptPtr<engine::AssetPack const> assets = {}
+        );
+        static Shader fromSource(Type shader_type, std::filesystem::path const& shader_file, std::string_view program);
 
         Shader(Shader const&)            = delete;
         Shader& operator=(Shader const&) = delete;
@@ -49,11 +69,24 @@ namespace render
         constexpr static GLuint Texture  = 1;
         constexpr static GLuint Normal   = 2;
 
+        // Per instance attributes of the instanced variants, the model matrix taking one location per column.
+        constexpr static GLuint InstanceModel     = 3;
+        constexpr static GLuint InstanceColor     = 7;
+        constexpr static GLuint InstanceAmbient   = 8;
+        constexpr static GLuint InstanceSpecular  = 9;
+        constexpr static GLuint InstanceShininess = 10;
+
+        // Multiplies the color, per vertex. Meshes without colors of their own leave the attribute disabled, so it
+        // reads the value set once with glVertexAttrib, which must be white.
+        constexpr static GLuint VertexColor = 11;
+
         constexpr static GLuint Camera = 0;
         constexpr static GLuint Scene  = 1;
     private:
         GLuint program_id_, model_id_, color_id_, texture_id_, ambient_id_, specular_id_, shininess_id_;
         bool   is_filter_;
+
+        std::unique_ptr<Pipeline> instanced_;
     public:
         Pipeline(Pipeline const&)            = delete;
         Pipeline& operator=(Pipeline const&) = delete;
@@ -81,7 +114,14 @@ namespace render
         [[nodiscard]] GLuint ambientId() const;
         [[nodiscard]] GLuint specularId() const;
         [[nodiscard]] GLuint shininessId() const;
+
+        // Variant drawing many objects in one call, reading their model matrices and materials per instance instead of
+        // from uniforms. Objects using a pipeline without one are always drawn one at a time.
+        void                                 setInstanced(Pipeline&& instanced);
+        [[nodiscard]] OptPtr<Pipeline const> instanced() const;
     };
+
+    using PipelineHandle = Handle<Pipeline>;
 }
 
 bool operator==(render::Pipeline const& lhs, render::Pipeline const& rhs);
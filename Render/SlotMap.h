@@ -0,0 +1,144 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "../Utils.h"
+
+namespace render
+{
+    // Reference to an element of a SlotMap, packing its slot's index and the generation the slot had when the element
+    // was added into 32 bits. Removing the element bumps the generation, so a stale handle finds nothing instead of
+    // whatever reuses the slot. Default constructed handles are null.
+    template <class T>
+    class Handle
+    {
+        std::uint32_t bits_;
+
+    public:
+        static constexpr unsigned      IndexBits     = 24;
+        static constexpr std::uint32_t MaxIndex      = (std::uint32_t {1} << IndexBits) - 2; // The last one is null's.
+        static constexpr std::uint32_t MaxGeneration = (std::uint32_t {1} << (32 - IndexBits)) - 1;
+
+        constexpr Handle()
+            : bits_ {~std::uint32_t {0}}
+        {}
+
+        constexpr Handle(std::uint32_t const index, std::uint32_t const generation)
+            : bits_ {generation << IndexBits | index}
+        {}
+
+        [[nodiscard]] constexpr std::uint32_t index() const { return bits_ & ((std::uint32_t {1} << IndexBits) - 1); }
+        [[nodiscard]] constexpr std::uint32_t generation() const { return bits_ >> IndexBits; }
+
+        constexpr explicit operator bool() const { return *this != Handle {}; }
+
+        constexpr bool operator==(Handle const other) const { return bits_ == other.bits_; }
+        constexpr bool operator!=(Handle const other) const { return bits_ != other.bits_; }
+    };
+
+    // Elements addressed by generational handles, added, removed and looked up in constant time. Freed slots are
+    // reused until their generation runs out, after which they are retired so that no handle is ever ambiguous.
+    // Elements never move, so references to them stay valid until they are removed. The handles are typed by the key,
+    // which only differs from the element when the map holds where something else is stored.
+    template <class T, class Key = T>
+    class SlotMap
+    {
+    public:
+        using Handle = render::Handle<Key>;
+
+    private:
+        struct Slot
+        {
+            std::optional<T> value;
+            std::uint32_t    generation = 0;
+        };
+
+        std::deque<Slot>           slots_;
+        std::vector<std::uint32_t> free_;
+        std::size_t                size_ = 0;
+
+    public:
+        template <class... Args>
+        Handle emplace(Args&&... args)
+        {
+            if (free_.empty())
+            {
+                if (slots_.size() > Handle::MaxIndex) throw std::length_error("Too many elements for their handles.");
+                free_.push_back(static_cast<std::uint32_t>(slots_.size()));
+                slots_.emplace_back();
+            }
+
+            // The slot is only taken once the element is constructed, so a throwing constructor leaves it free.
+            auto const index = free_.back();
+            auto&      slot  = slots_[index];
+            slot.value.emplace(std::forward<Args>(args)...);
+            free_.pop_back();
+            size_++;
+            return {index, slot.generation};
+        }
+
+        // Removes the element, returning whether there was one.
+        bool erase(Handle const handle)
+        {
+            if (!contains(handle)) return false;
+
+            auto& slot = slots_[handle.index()];
+            slot.value.reset();
+            if (++slot.generation < Handle::MaxGeneration) free_.push_back(handle.index());
+            size_--;
+            return true;
+        }
+
+        [[nodiscard]] bool contains(Handle const handle) const
+        {
+            return handle.index() < slots_.size()
+                   && slots_[handle.index()].generation == handle.generation()
+                   && slots_[handle.index()].value.has_value();
+        }
+
+        // Null when the handle is null or its element was removed.
+        [[nodiscard]] OptPtr<T> get(Handle const handle)
+        {
+            return contains(handle) ? &*slots_[handle.index()].value : nullptr;
+        }
+
+        [[nodiscard]] OptPtr<T const> get(Handle const handle) const
+        {
+            return contains(handle) ? &*slots_[handle.index()].value : nullptr;
+        }
+
+        T& operator[](Handle const handle)
+        {
+            if (!contains(handle)) throw std::invalid_argument("Handle to a removed element.");
+            return *slots_[handle.index()].value;
+        }
+
+        T const& operator[](Handle const handle) const
+        {
+            if (!contains(handle)) throw std::invalid_argument("Handle to a removed element.");
+            return *slots_[handle.index()].value;
+        }
+
+        // The element after the handle's in slot order, the first one after a null handle, and null after the last,
+        // so stepping through a SlotMap works like stepping through a container and wrapping around at its end.
+        [[nodiscard]] Handle next(Handle const handle) const
+        {
+            for (auto index = handle ? handle.index() + 1 : 0; index < slots_.size(); index++)
+                if (slots_[index].value) return {index, slots_[index].generation};
+            return {};
+        }
+
+        [[nodiscard]] Handle prev(Handle const handle) const
+        {
+            for (auto index = handle ? handle.index() : static_cast<std::uint32_t>(slots_.size()); index-- > 0;)
+                if (slots_[index].value) return {index, slots_[index].generation};
+            return {};
+        }
+
+        [[nodiscard]] std::size_t size() const { return size_; }
+    };
+}
@@ -2,6 +2,8 @@
 
 #include <iostream>
 
+#include "GlState.h"
+#include "../Engine/AssetPack.h"
 
 #include "FreeImage.h"
 
@@ -9,8 +11,17 @@ namespace render
 {
     void TextureLoader::Deleter::operator()(FIBITMAP* data) const { FreeImage_Unload(data); }
 
-    TextureLoader TextureLoader::fromFile(std::filesystem::path const& texture_file)
+    TextureLoader TextureLoader::fromFile(
+        std::filesystem::path const&          texture_file,
+        OptPtr<engine::AssetPack const> const assets
+    )
     {
+        if (assets != nullptr)
+        {
+            if (auto const baked = assets->texture(texture_file))
+                return TextureLoader {baked->width, baked->height, nullptr, baked->pixels};
+        }
+
         try
         {
             if (!exists(texture_file))
@@ -52,9 +63,9 @@ namespace render
         #else
         constexpr auto Format = GL_RGBA;
         #endif
-        auto const [width, height, data] = std::move(texture);
+        auto const [width, height, data, baked] = std::move(texture);
         glGenTextures(1, &tex_id_);
-        glBindTexture(GL_TEXTURE_2D, tex_id_);
+        GlState::current().bindTexture(0, tex_id_);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -62,10 +73,10 @@ namespace render
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        auto const pixels = FreeImage_GetBits(data.get());
+        auto const pixels = data ? FreeImage_GetBits(data.get()) : baked;
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, Format, GL_UNSIGNED_BYTE, pixels);
         glGenerateMipmap(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GlState::current().bindTexture(0, 0);
     }
 
     Texture Texture::fromFile(std::filesystem::path const& texture_file)
@@ -95,6 +106,7 @@ namespace render
     {
         if (tex_id_ != 0)
         {
+            GlState::current().forgetTexture(tex_id_);
             glDeleteTextures(1, &tex_id_);
         }
     }
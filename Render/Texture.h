@@ -4,6 +4,14 @@
 #include "FreeImage.h"
 #include "GL/glew.h"
 
+#include "SlotMap.h"
+#include "../Utils.h"
+
+namespace engine
+{
+    class AssetPack;
+}
+
 namespace render
 {
     struct TextureLoader
@@ -15,11 +23,17 @@ namespace render
 
         using Buffer = std::unique_ptr<FIBITMAP, Deleter>;
 
-        static TextureLoader fromFile(std::filesystem::path const& texture_file);
+        static TextureLoader fromFile(
+            std::filesystem::path const&    texture_file,
+            OptPtr<engine::AssetPack const> assets = {}
+        );
         static TextureLoader white(unsigned len);
 
         unsigned width, height;
         Buffer   data;
+
+        // Decoded pixels mapped from the asset pack, used instead of data when it is empty.
+        Ptr<void const> baked = nullptr;
     };
 
     class Texture
@@ -41,4 +55,6 @@ namespace render
 
         [[nodiscard]] GLuint texId() const;
     };
+
+    using TextureHandle = Handle<Texture>;
 }